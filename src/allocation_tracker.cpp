@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+#include "allocation_tracker.h"
+
+#if !defined(__SWITCH__)
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+
+namespace {
+
+std::atomic<uint64_t> num_allocations{0};
+std::atomic<uint64_t> num_bytes{0};
+
+// Set by setStrictAllocations(), along with the frames to wait
+std::atomic<bool> strict_enabled{false};
+std::atomic<units::Frame> strict_warmup{0};
+// Set by a strict AllocationTracker for the frames of its own thread
+thread_local bool strict_thread{false};
+
+// Where a call site lives, as "object+offset (symbol)" where the platform
+// can tell, for addr2line. Formats into |text| so that it can run inside
+// operator new.
+void formatAddress(const void* address, char* text, std::size_t size)
+{
+#if !defined(__SWITCH__)
+    Dl_info info;
+    if (dladdr(address, &info) != 0 && info.dli_fname != nullptr) {
+        const unsigned long offset = static_cast<unsigned long>(
+                static_cast<const char*>(address) -
+                static_cast<const char*>(info.dli_fbase));
+        std::snprintf(text, size, "%s+0x%lx (%s)", info.dli_fname, offset,
+                info.dli_sname != nullptr ? info.dli_sname : "?");
+        return;
+    }
+#endif
+    std::snprintf(text, size, "%p", address);
+}
+
+// Return addresses of an allocation, innermost first, starting at the
+// caller of operator new. Containers allocate from out-of-line helpers
+// shared by every caller, so one address rarely tells where the memory
+// went.
+const int kStackDepth{6};
+struct Stack {
+    void* frames[kStackDepth];
+    int depth;
+};
+
+void captureStack(const void* caller, Stack& stack)
+{
+    stack.frames[0] = const_cast<void*>(caller);
+    stack.depth = 1;
+#if !defined(__SWITCH__)
+    // backtrace() only allocates through malloc, which is not counted
+    void* frames[kStackDepth + 8];
+    const int depth = backtrace(frames, kStackDepth + 8);
+    for (int i = 0; i < depth; ++i) {
+        if (frames[i] == caller) {
+            stack.depth = std::min(depth - i, kStackDepth);
+            std::copy(frames + i, frames + i + stack.depth, stack.frames);
+            break;
+        }
+    }
+#endif
+}
+
+void printStack(const Stack& stack)
+{
+    for (int i = 0; i < stack.depth; ++i) {
+        char text[256];
+        formatAddress(stack.frames[i], text, sizeof(text));
+        std::fprintf(stderr, "    %s\n", text);
+    }
+}
+
+#ifndef NDEBUG
+// Open addressing over stacks. Filled from inside operator new, so it is
+// fixed in size and never allocates; sites past the capacity are still
+// counted in the totals.
+struct CallSite {
+    Stack stack;
+    uint64_t allocations;
+    uint64_t bytes;
+};
+const std::size_t kNumCallSites{4096};
+CallSite call_sites[kNumCallSites];
+std::atomic_flag call_sites_lock = ATOMIC_FLAG_INIT;
+
+bool operator==(const Stack& a, const Stack& b)
+{
+    return a.depth == b.depth &&
+        std::equal(a.frames, a.frames + a.depth, b.frames);
+}
+
+void recordCallSite(const Stack& stack, std::size_t size)
+{
+    uint64_t hash = 0;
+    for (int i = 0; i < stack.depth; ++i) {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(stack.frames[i])) *
+            0x9e3779b97f4a7c15ull;
+    }
+    while (call_sites_lock.test_and_set(std::memory_order_acquire)) {}
+    for (std::size_t probe = 0; probe < kNumCallSites; ++probe) {
+        CallSite& site = call_sites[((hash >> 52) + probe) % kNumCallSites];
+        if (site.allocations == 0) {
+            site.stack = stack;
+        }
+        if (site.stack == stack) {
+            ++site.allocations;
+            site.bytes += size;
+            break;
+        }
+    }
+    call_sites_lock.clear(std::memory_order_release);
+}
+#endif
+
+void* allocate(std::size_t size, const void* caller)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    num_bytes.fetch_add(size, std::memory_order_relaxed);
+#ifndef NDEBUG
+    Stack stack;
+    captureStack(caller, stack);
+    recordCallSite(stack, size);
+#endif
+    if (strict_thread) {
+        strict_thread = false;
+#ifdef NDEBUG
+        Stack stack;
+        captureStack(caller, stack);
+#endif
+        std::fprintf(stderr, "Allocated %lu bytes in a strict frame at\n",
+                static_cast<unsigned long>(size));
+        printStack(stack);
+        std::abort();
+    }
+    return std::malloc(std::max<std::size_t>(size, 1));
+}
+
+void* allocateOrThrow(std::size_t size, const void* caller)
+{
+    void* memory = allocate(size, caller);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+} // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+    return allocateOrThrow(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocateOrThrow(size, __builtin_return_address(0));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, __builtin_return_address(0));
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+AllocationCounts getAllocationCounts()
+{
+    return AllocationCounts{
+        num_allocations.load(std::memory_order_relaxed),
+        num_bytes.load(std::memory_order_relaxed)};
+}
+
+void setStrictAllocations(units::Frame warmup_frames)
+{
+    strict_warmup.store(warmup_frames, std::memory_order_relaxed);
+    strict_enabled.store(true, std::memory_order_release);
+}
+
+void reportAllocationSites(std::ostream& out, std::size_t max_sites)
+{
+#ifndef NDEBUG
+    // Reserved up front: allocating under the lock would deadlock
+    std::vector<CallSite> sites;
+    sites.reserve(kNumCallSites);
+    while (call_sites_lock.test_and_set(std::memory_order_acquire)) {}
+    for (const auto& site : call_sites) {
+        if (site.allocations > 0) {
+            sites.push_back(site);
+        }
+    }
+    call_sites_lock.clear(std::memory_order_release);
+    std::sort(sites.begin(), sites.end(),
+            [](const CallSite& a, const CallSite& b) {
+                return a.allocations > b.allocations;
+            });
+    sites.resize(std::min(sites.size(), max_sites));
+    for (const auto& site : sites) {
+        out << std::setfill(' ') << std::setw(10) << site.allocations
+            << " allocations " << std::setw(12) << site.bytes << " bytes\n";
+        for (int i = 0; i < site.stack.depth; ++i) {
+            char text[256];
+            formatAddress(site.stack.frames[i], text, sizeof(text));
+            out << "    " << text << "\n";
+        }
+    }
+#else
+    (void)max_sites;
+    out << "  (call sites are only tracked without NDEBUG)\n";
+#endif
+}
+
+AllocationTracker::Scope::Scope(AllocationTracker& tracker) :
+    tracker_(tracker)
+{
+    tracker_.startFrame();
+}
+
+AllocationTracker::Scope::~Scope()
+{
+    tracker_.endFrame();
+}
+
+AllocationTracker::AllocationTracker() :
+    frame_start_{0, 0},
+    num_frames_{0},
+    num_allocating_frames_{0},
+    total_{0, 0},
+    worst_{0, 0},
+    worst_frame_{0}
+{}
+
+AllocationTracker::~AllocationTracker()
+{
+    strict_thread = false;
+}
+
+void AllocationTracker::startFrame()
+{
+    strict_thread = strict_enabled.load(std::memory_order_acquire) &&
+        num_frames_ >= strict_warmup.load(std::memory_order_relaxed);
+    frame_start_ = getAllocationCounts();
+}
+
+void AllocationTracker::endFrame()
+{
+    const AllocationCounts end = getAllocationCounts();
+    strict_thread = false;
+    const AllocationCounts frame{
+        end.allocations - frame_start_.allocations,
+        end.bytes - frame_start_.bytes};
+    if (frame.allocations > 0) {
+        ++num_allocating_frames_;
+    }
+    total_.allocations += frame.allocations;
+    total_.bytes += frame.bytes;
+    if (frame.allocations > worst_.allocations) {
+        worst_ = frame;
+        worst_frame_ = num_frames_;
+    }
+    ++num_frames_;
+}
+
+void AllocationTracker::report(std::ostream& out) const
+{
+    if (num_frames_ == 0) {
+        return;
+    }
+    // Restores the caller's formatting afterwards; a local std::ostringstream
+    // would allocate inside the tracker
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1)
+        << "allocations: "
+        << static_cast<double>(total_.allocations) / num_frames_
+        << " per frame average ("
+        << static_cast<double>(total_.bytes) / num_frames_ << " bytes), "
+        << num_allocating_frames_ << " of " << num_frames_
+        << " frames allocated, worst frame " << worst_frame_ << " with "
+        << worst_.allocations << " (" << worst_.bytes << " bytes)\n";
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,61 @@
+#ifndef ALLOCATION_TRACKER_H_
+#define ALLOCATION_TRACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include "units.h"
+
+// Heap allocations made through operator new, by every thread, since the
+// program started. allocation_tracker.cpp replaces the global operators
+// new and delete to count them; builds without NDEBUG also count them per
+// call site.
+struct AllocationCounts {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+AllocationCounts getAllocationCounts();
+
+// Makes every AllocationTracker strict once it has seen |warmup_frames|
+// frames: from then on, an allocation by the thread running its frames
+// aborts the program, naming the size and call site. Gameplay that has
+// warmed up should not need the heap.
+void setStrictAllocations(units::Frame warmup_frames);
+
+// Prints the |max_sites| call sites that allocated the most, with their
+// counts; only builds without NDEBUG track call sites.
+void reportAllocationSites(std::ostream& out, std::size_t max_sites);
+
+// Counts the allocations of each frame of a loop, on all threads, and
+// enforces setStrictAllocations() on the thread running the loop.
+struct AllocationTracker {
+    // Counts the allocations made until it goes out of scope as one frame
+    struct Scope {
+        explicit Scope(AllocationTracker& tracker);
+        ~Scope();
+    private:
+        AllocationTracker& tracker_;
+    };
+
+    AllocationTracker();
+    AllocationTracker(const AllocationTracker&)=delete;
+    AllocationTracker& operator=(const AllocationTracker&)=delete;
+    ~AllocationTracker();
+
+    void startFrame();
+    void endFrame();
+
+    // Prints allocations and bytes per frame, and the worst frame
+    void report(std::ostream& out) const;
+
+private:
+    AllocationCounts frame_start_;
+    units::Frame num_frames_;
+    units::Frame num_allocating_frames_;
+    AllocationCounts total_;
+    AllocationCounts worst_;
+    units::Frame worst_frame_;
+};
+
+#endif /* ALLOCATION_TRACKER_H_ */
@@ -0,0 +1,72 @@
+#include "animation.h"
+#include "enum_table.h"
+#include "timer.h"
+
+namespace {
+
+// Indexed by ClipId
+const AnimationClip kClips[] = {
+    // PLAYER_WALK: picks the stride; the sprite depends on the player state
+    {nullptr, 0, 0, 0, 0, 3, 15, AnimationClip::Playback::PING_PONG},
+    // FIRST_CAVE_BAT_FLY_LEFT
+    {"NpcCemet", units::tileToGame(2), units::tileToGame(2),
+        units::tileToGame(1), units::tileToGame(1),
+        3, 13, AnimationClip::Playback::LOOP},
+    // FIRST_CAVE_BAT_FLY_RIGHT
+    {"NpcCemet", units::tileToGame(2), units::tileToGame(3),
+        units::tileToGame(1), units::tileToGame(1),
+        3, 13, AnimationClip::Playback::LOOP},
+};
+static_assert(sizeof(kClips) / sizeof(kClips[0]) == enumCount<ClipId>(),
+        "Every clip needs a definition!");
+
+} // anonymous namespace
+
+units::Frame AnimationClip::getFrame(std::chrono::milliseconds elapsed) const
+{
+    if (elapsed.count() <= 0 || num_frames < 2) {
+        return 0;
+    }
+    const auto step = static_cast<units::Frame>(elapsed.count() * fps / 1000);
+    switch (playback) {
+    case Playback::LOOP:
+        break;
+    case Playback::PING_PONG: {
+        const units::Frame period = 2 * (num_frames - 1);
+        const units::Frame position = step % period;
+        return (position < num_frames) ? position : period - position;
+    }
+    }
+    return step % num_frames;
+}
+
+const AnimationClip& getClip(ClipId clip)
+{
+    return kClips[static_cast<int>(clip)];
+}
+
+SpriteRegistry::Id addClipSprites(SpriteRegistry& sprites, ClipId clip)
+{
+    const AnimationClip& definition = getClip(clip);
+    return sprites.add(definition.sheet,
+            units::gameToPixel(definition.source_x),
+            units::gameToPixel(definition.source_y),
+            units::gameToPixel(definition.width),
+            units::gameToPixel(definition.height),
+            definition.num_frames);
+}
+
+Animation Animation::start(ClipId clip)
+{
+    return Animation{clip, Timer::now()};
+}
+
+void Animation::restart()
+{
+    start_time = Timer::now();
+}
+
+units::Frame Animation::getFrame() const
+{
+    return getClip(clip).getFrame(Timer::now() - start_time);
+}
@@ -0,0 +1,60 @@
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <chrono>
+#include "sprite_registry.h"
+#include "units.h"
+
+// Every animation clip in the game; kClips in animation.cpp holds their
+// definitions in the same order.
+enum class ClipId {
+    FIRST,
+    PLAYER_WALK = FIRST,
+    FIRST_CAVE_BAT_FLY_LEFT,
+    FIRST_CAVE_BAT_FLY_RIGHT,
+    LAST
+};
+
+// Definition of an animation, shared by everything that plays it. The
+// frames lie side by side on the sheet, the first one at the source
+// position; a clip with no sheet only keeps time for its owner.
+struct AnimationClip {
+    enum class Playback {
+        LOOP,
+        // Forwards then backwards, without repeating the end frames
+        PING_PONG
+    };
+
+    const char* sheet;
+    units::Game source_x;
+    units::Game source_y;
+    units::Game width;
+    units::Game height;
+    units::Frame num_frames;
+    units::FPS fps;
+    Playback playback;
+
+    // Frame shown |elapsed| after the clip started
+    units::Frame getFrame(std::chrono::milliseconds elapsed) const;
+};
+
+const AnimationClip& getClip(ClipId clip);
+
+// Adds the frames of |clip| to |sprites| and returns the id of the first;
+// the others follow it in order.
+SpriteRegistry::Id addClipSprites(SpriteRegistry& sprites, ClipId clip);
+
+// One playing animation: all of its state is which clip and since when, so
+// there is nothing to update per frame. The frame to show is worked out
+// from the world clock (Timer::now) when asked for.
+struct Animation {
+    ClipId clip;
+    std::chrono::milliseconds start_time;
+
+    static Animation start(ClipId clip);
+    void restart();
+
+    units::Frame getFrame() const;
+};
+
+#endif /* ANIMATION_H_ */
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "benchmark.h"
+#include "broadphase.h"
+#include "enemy_store.h"
+#include "first_cave_bat.h"
+#include "game.h"
+#include "graphics.h"
+#include "job_system.h"
+#include "map.h"
+#include "particle_system.h"
+#include "rectangle.h"
+#include "rng.h"
+#include "sdlengine.h"
+#include "sweep.h"
+#include "vector.h"
+
+namespace {
+
+const std::chrono::milliseconds kFrameTime{1000 / 60};
+
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+void report(const char* name, std::size_t count,
+        const Milliseconds total, const Milliseconds worst,
+        units::Frame num_frames)
+{
+    std::cout << name << ": " << count << " entities, "
+        << num_frames << " frames, "
+        << total.count() / num_frames << " ms/frame average, "
+        << worst.count() << " ms worst (budget "
+        << Milliseconds(kFrameTime).count() << " ms)\n";
+}
+
+} // anonymous namespace
+
+namespace benchmark {
+
+void runEnemies(std::size_t num_bats, units::Frame num_frames,
+        std::size_t num_threads)
+{
+    using std::chrono::high_resolution_clock;
+
+    std::unique_ptr<JobSystem> jobs = num_threads > 0
+        ? std::make_unique<JobSystem>(num_threads)
+        : std::make_unique<JobSystem>();
+
+    // Bats on a square grid, two tiles apart, the player in the middle
+    EnemyStore enemies;
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(num_bats)));
+    for (std::size_t i = 0; i < num_bats; ++i) {
+        FirstCaveBat::spawn(enemies, Vector<units::Game>{
+                units::tileToGame(2 * (i % side)),
+                units::tileToGame(2 * (i / side))});
+    }
+    const units::Game middle = units::tileToGame(side);
+    const Rectangle player(middle, middle,
+            units::tileToGame(1), units::tileToGame(1));
+
+    Milliseconds total{0};
+    Milliseconds worst{0};
+    std::size_t contacts = 0;
+    for (units::Frame frame = 0; frame < num_frames; ++frame) {
+        const auto start = high_resolution_clock::now();
+
+        enemies.update(kFrameTime, middle, *jobs);
+        for (EnemyStore::Index i = 0; i < enemies.size(); ++i) {
+            if (enemies.getDamageRectangle(i).collidesWith(player)) {
+                ++contacts;
+            }
+        }
+
+        const Milliseconds elapsed = high_resolution_clock::now() - start;
+        total += elapsed;
+        worst = std::max(worst, elapsed);
+    }
+    report("enemies", enemies.size(), total, worst, num_frames);
+    std::cout << "  " << jobs->getNumThreads() << " threads, "
+        << contacts << " player contacts\n";
+}
+
+void runBroadphase(std::size_t num_bats, units::Frame num_frames)
+{
+    using std::chrono::high_resolution_clock;
+
+    // Bats scattered over a square with four tiles per bat, so the density
+    // stays the same as the count grows. One projectile per ten bats.
+    std::mt19937 engine(31);
+    const auto side = units::tileToGame(
+            2 * static_cast<units::Game>(std::ceil(std::sqrt(num_bats))));
+    std::uniform_real_distribution<units::Game> coordinate(0.0, side);
+    EnemyStore enemies;
+    for (std::size_t i = 0; i < num_bats; ++i) {
+        FirstCaveBat::spawn(enemies, Vector<units::Game>{
+                coordinate(engine), coordinate(engine)});
+    }
+    std::vector<Rectangle> projectiles;
+    for (std::size_t i = 0; i < num_bats / 10; ++i) {
+        projectiles.emplace_back(coordinate(engine), coordinate(engine),
+                units::tileToGame(1), units::kHalfTile);
+    }
+    const Rectangle player(side / 2, side / 2,
+            units::tileToGame(1), units::tileToGame(1));
+
+    Broadphase grid;
+    JobSystem jobs;
+    Milliseconds brute_total{0};
+    Milliseconds grid_total{0};
+    Milliseconds grid_worst{0};
+    std::size_t brute_pairs = 0;
+    std::size_t brute_hits = 0;
+    std::size_t grid_pairs = 0;
+    std::size_t grid_hits = 0;
+    for (units::Frame frame = 0; frame < num_frames; ++frame) {
+        enemies.update(kFrameTime, player.getLeft(), jobs);
+
+        // Every projectile and the player against every bat
+        auto start = high_resolution_clock::now();
+        for (EnemyStore::Index i = 0; i < enemies.size(); ++i) {
+            const Rectangle bat = enemies.getCollisionRectangle(i);
+            for (const Rectangle& projectile : projectiles) {
+                brute_hits += bat.collidesWith(projectile);
+            }
+            brute_hits += bat.collidesWith(player);
+        }
+        brute_pairs += enemies.size() * (projectiles.size() + 1);
+        brute_total += high_resolution_clock::now() - start;
+
+        // Only the candidates sharing a cell
+        start = high_resolution_clock::now();
+        grid.rebuild(enemies.size(), [&enemies](EnemyStore::Index i) {
+            return enemies.getCollisionRectangle(i);
+        });
+        const auto test = [&](const Rectangle& rect) {
+            grid.query(rect, [&](EnemyStore::Index i) {
+                ++grid_pairs;
+                grid_hits +=
+                    enemies.getCollisionRectangle(i).collidesWith(rect);
+            });
+        };
+        for (const Rectangle& projectile : projectiles) {
+            test(projectile);
+        }
+        test(player);
+        const Milliseconds elapsed = high_resolution_clock::now() - start;
+        grid_total += elapsed;
+        grid_worst = std::max(grid_worst, elapsed);
+    }
+    report("broadphase", enemies.size() + projectiles.size() + 1,
+            grid_total, grid_worst, num_frames);
+    std::cout << "  brute force: " << brute_pairs / num_frames
+        << " pairs/frame, " << brute_total.count() / num_frames
+        << " ms/frame, " << brute_hits << " hits\n"
+        << "  grid:        " << grid_pairs / num_frames
+        << " pairs/frame, " << grid_total.count() / num_frames
+        << " ms/frame, " << grid_hits << " hits\n";
+}
+
+void runTrig(std::size_t num_angles, units::Frame num_frames)
+{
+    using std::chrono::high_resolution_clock;
+
+    std::mt19937 engine(33);
+    std::uniform_real_distribution<units::Degrees> degrees(0.0, 36000.0);
+    std::vector<units::Degrees> angles(num_angles);
+    for (auto& angle : angles) {
+        angle = degrees(engine);
+    }
+    std::vector<units::Game> sines(num_angles);
+
+    // Same loop for every implementation, |sine(i)| filling sines[i..]
+    const auto time = [&](const char* name, std::size_t step, auto sine) {
+        Milliseconds total{0};
+        for (units::Frame frame = 0; frame < num_frames; ++frame) {
+            const auto start = high_resolution_clock::now();
+            for (std::size_t i = 0; i + step <= num_angles; i += step) {
+                sine(i);
+            }
+            total += high_resolution_clock::now() - start;
+        }
+        double error = 0.0;
+        for (std::size_t i = 0; i < num_angles; ++i) {
+            error = std::max(error, std::abs(sines[i] -
+                        std::sin(units::degreesToRadians(angles[i]))));
+        }
+        std::cout << "  " << name << ": "
+            << total.count() / num_frames << " ms/frame, max error "
+            << error << "\n";
+        return total;
+    };
+
+    std::cout << "trig: " << num_angles << " angles, "
+        << num_frames << " frames, UNITS_TRIG=" << UNITS_TRIG << "\n";
+    const Milliseconds libm = time("libm", 1, [&](std::size_t i) {
+        sines[i] = std::sin(units::degreesToRadians(angles[i]));
+    });
+    const Milliseconds scalar = time("units::sin", 1, [&](std::size_t i) {
+        sines[i] = units::sin(angles[i]);
+    });
+    const Milliseconds lanes = time("units::sin lanes", units::kNumLanes,
+            [&](std::size_t i) {
+                units::Lanes values;
+                std::memcpy(&values, &angles[i], sizeof(values));
+                values = units::sin(values);
+                std::memcpy(&sines[i], &values, sizeof(values));
+            });
+    std::cout << "  speedup over libm: " << libm / scalar << "x scalar, "
+        << libm / lanes << "x lanes\n";
+}
+
+void runParticles(std::size_t num_particles, units::Frame num_frames)
+{
+    using std::chrono::high_resolution_clock;
+
+    const SDLEngine sdl_engine(0);
+    Graphics graphics(Graphics::Output::OFFSCREEN);
+    JobSystem jobs;
+    ParticleSystem particles(graphics);
+
+    // Spread over the screen, topped up as they burn out
+    Rng random(36);
+
+    Milliseconds update_total{0};
+    Milliseconds draw_total{0};
+    Milliseconds worst{0};
+    for (units::Frame frame = 0; frame < num_frames; ++frame) {
+        while (particles.size() < num_particles) {
+            const units::Game x =
+                random.uniform(0.0, units::tileToGame(Game::kScreenWidth));
+            const units::Game y =
+                random.uniform(0.0, units::tileToGame(Game::kScreenHeight));
+            particles.addHeadBumpParticle(Vector<units::Game>{x, y}, random);
+        }
+
+        const auto start = high_resolution_clock::now();
+        particles.update(kFrameTime, jobs);
+        const auto updated = high_resolution_clock::now();
+        graphics.clear();
+        particles.draw(graphics);
+        const auto drawn = high_resolution_clock::now();
+
+        update_total += updated - start;
+        draw_total += drawn - updated;
+        worst = std::max(worst, Milliseconds(drawn - start));
+    }
+    report("particles", num_particles, update_total + draw_total, worst,
+            num_frames);
+    std::cout << "  update " << update_total.count() / num_frames
+        << " ms/frame, draw " << draw_total.count() / num_frames
+        << " ms/frame, " << jobs.getNumThreads() << " threads\n";
+}
+
+void runRaycasts(std::size_t num_rays, units::Frame num_frames)
+{
+    using std::chrono::high_resolution_clock;
+
+    const SDLEngine sdl_engine(0);
+    Graphics graphics(Graphics::Output::OFFSCREEN);
+    const units::Tile size = 128;
+    const std::unique_ptr<Map> map =
+        Map::createCaveMap(graphics, size, size, 27);
+
+    // Rays up to 16 tiles long from anywhere in the cave
+    Rng random(27);
+    std::vector<Vector<units::Game> > origins(num_rays);
+    std::vector<Vector<units::Game> > deltas(num_rays);
+    for (std::size_t i = 0; i < num_rays; ++i) {
+        origins[i] = Vector<units::Game>{
+            random.uniform(0.0, units::tileToGame(size)),
+            random.uniform(0.0, units::tileToGame(size))};
+        const units::Degrees angle = random.angle();
+        const units::Game length = random.uniform(0.0, units::tileToGame(16));
+        deltas[i] = Vector<units::Game>{
+            length * std::cos(units::degreesToRadians(angle)),
+            length * std::sin(units::degreesToRadians(angle))};
+    }
+    std::vector<TileHit> rays(num_rays);
+    std::vector<TileHit> sweeps(num_rays);
+
+    Milliseconds ray_total{0};
+    Milliseconds sweep_total{0};
+    Milliseconds worst{0};
+    for (units::Frame frame = 0; frame < num_frames; ++frame) {
+        auto start = high_resolution_clock::now();
+        for (std::size_t i = 0; i < num_rays; ++i) {
+            rays[i] = raycast(*map, origins[i], deltas[i]);
+        }
+        const Milliseconds elapsed = high_resolution_clock::now() - start;
+        ray_total += elapsed;
+        worst = std::max(worst, elapsed);
+
+        start = high_resolution_clock::now();
+        for (std::size_t i = 0; i < num_rays; ++i) {
+            sweeps[i] = sweepRectangle(*map,
+                    Rectangle(origins[i].x, origins[i].y, 0.0, 0.0),
+                    deltas[i]);
+        }
+        sweep_total += high_resolution_clock::now() - start;
+    }
+
+    // A zero-size sweep must find the same tile, time and face; times only
+    // differ by the rounding of the DDA's running sums
+    std::size_t hits = 0;
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < num_rays; ++i) {
+        const TileHit& ray = rays[i];
+        const TileHit& sweep = sweeps[i];
+        hits += ray.hit;
+        if (ray.hit != sweep.hit || (ray.hit &&
+                    (ray.row != sweep.row || ray.col != sweep.col ||
+                     std::abs(ray.time - sweep.time) > 1e-9 ||
+                     ray.normal.x != sweep.normal.x ||
+                     ray.normal.y != sweep.normal.y))) {
+            ++mismatches;
+        }
+    }
+    report("raycast", num_rays, ray_total, worst, num_frames);
+    std::cout << "  sweepRectangle " << sweep_total.count() / num_frames
+        << " ms/frame, " << hits << " hits, "
+        << mismatches << " rays disagree\n";
+}
+
+} // benchmark
@@ -0,0 +1,37 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <cstddef>
+#include "units.h"
+
+// Headless stress benchmarks, started from the command line (see main.cpp).
+// They print their results to stdout and need no window or input.
+namespace benchmark {
+
+// Simulates |num_bats| FirstCaveBats for |num_frames| frames at 60 Hz,
+// including their contact tests against a player, and reports the time
+// spent per frame. Updates use |num_threads| threads, or one per core if 0.
+void runEnemies(std::size_t num_bats, units::Frame num_frames,
+        std::size_t num_threads);
+
+// Tests projectiles and a player against |num_bats| scattered bats, once by
+// brute force and once through a Broadphase, and reports the pairs tested
+// and the time spent per frame by each.
+void runBroadphase(std::size_t num_bats, units::Frame num_frames);
+
+// Times units::sin(), one angle and one set of lanes at a time, against
+// std::sin on |num_angles| angles, and reports its largest error.
+void runTrig(std::size_t num_angles, units::Frame num_frames);
+
+// Keeps |num_particles| HeadBumpParticles alive on an offscreen renderer
+// and reports the time spent updating and drawing them per frame.
+void runParticles(std::size_t num_particles, units::Frame num_frames);
+
+// Casts |num_rays| random rays through a generated cave every frame with
+// raycast() and again as zero-size sweepRectangle() calls, reports the time
+// per frame of each and counts the rays on which the two disagree.
+void runRaycasts(std::size_t num_rays, units::Frame num_frames);
+
+} // benchmark
+
+#endif /* BENCHMARK_H_ */
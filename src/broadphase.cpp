@@ -0,0 +1,50 @@
+#include <algorithm>
+#include "broadphase.h"
+
+Broadphase::Broadphase() :
+    ranges_(),
+    bucket_mask_{0},
+    bucket_starts_(),
+    bucket_ends_(),
+    entries_(),
+    visit_marks_(),
+    visit_mark_{0}
+{}
+
+std::size_t Broadphase::size() const
+{
+    return ranges_.size();
+}
+
+Broadphase::CellRange Broadphase::getCellRange(const Rectangle& rect)
+{
+    // Same cells as Map::getTileRange(), without clamping to a map
+    const units::Game cell = units::tileToGame(1);
+    return CellRange{
+        static_cast<int>(std::floor(rect.getTop() / cell)),
+        static_cast<int>(std::floor(rect.getBottom() / cell)) + 1,
+        static_cast<int>(std::floor(rect.getLeft() / cell)),
+        static_cast<int>(std::floor(rect.getRight() / cell)) + 1
+    };
+}
+
+void Broadphase::allocateBuckets(std::size_t num_entries)
+{
+    // Power of two with at least one bucket per entry
+    std::size_t num_buckets = 1;
+    while (num_buckets < num_entries) {
+        num_buckets *= 2;
+    }
+    bucket_mask_ = num_buckets - 1;
+    bucket_starts_.assign(num_buckets + 1, 0);
+    entries_.resize(num_entries);
+}
+
+void Broadphase::startQuery()
+{
+    ++visit_mark_;
+    if (visit_mark_ == 0) {
+        std::fill(visit_marks_.begin(), visit_marks_.end(), 0);
+        visit_mark_ = 1;
+    }
+}
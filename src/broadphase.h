@@ -0,0 +1,122 @@
+#ifndef BROADPHASE_H_
+#define BROADPHASE_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rectangle.h"
+#include "units.h"
+
+// Spatial hash over map tile cells. Bodies are bucketed by every cell their
+// rectangle touches, once per frame with rebuild(); query() then yields the
+// bodies sharing a cell with a rectangle. Those are only candidates: callers
+// still run their own narrowphase test on them.
+//
+// Buckets are stored back to back (counting sort), so after the first few
+// frames neither rebuild() nor query() allocates.
+struct Broadphase {
+    typedef std::size_t Index;
+
+    Broadphase();
+
+    // Replaces the contents with bodies [0, count); bounds(i) returns the
+    // Rectangle of body i.
+    template <typename Bounds>
+    void rebuild(std::size_t count, Bounds bounds);
+
+    // Calls visitor(Index) once for every body sharing a cell with |rect|,
+    // in no particular order.
+    template <typename Visitor>
+    void query(const Rectangle& rect, Visitor visitor);
+
+    std::size_t size() const;
+
+private:
+    struct CellRange {
+        int first_row;
+        int end_row;
+        int first_col;
+        int end_col;
+    };
+    static CellRange getCellRange(const Rectangle& rect);
+    std::size_t getBucket(int row, int col) const;
+    void allocateBuckets(std::size_t num_entries);
+    void startQuery();
+
+    std::vector<CellRange> ranges_;
+    std::size_t bucket_mask_;
+    // Bodies of bucket b are entries_[bucket_starts_[b], bucket_starts_[b+1])
+    std::vector<std::size_t> bucket_starts_;
+    std::vector<std::size_t> bucket_ends_;
+    std::vector<Index> entries_;
+    // Bodies already reported by the current query
+    std::vector<uint32_t> visit_marks_;
+    uint32_t visit_mark_;
+};
+
+template <typename Bounds>
+void Broadphase::rebuild(std::size_t count, Bounds bounds)
+{
+    ranges_.resize(count);
+    std::size_t num_entries = 0;
+    for (Index i = 0; i < count; ++i) {
+        const CellRange range = getCellRange(bounds(i));
+        ranges_[i] = range;
+        num_entries += (range.end_row - range.first_row) *
+            (range.end_col - range.first_col);
+    }
+    allocateBuckets(num_entries);
+
+    for (const CellRange& range : ranges_) {
+        for (int row = range.first_row; row < range.end_row; ++row) {
+            for (int col = range.first_col; col < range.end_col; ++col) {
+                ++bucket_starts_[getBucket(row, col) + 1];
+            }
+        }
+    }
+    for (std::size_t b = 1; b < bucket_starts_.size(); ++b) {
+        bucket_starts_[b] += bucket_starts_[b - 1];
+    }
+    bucket_ends_.assign(bucket_starts_.begin(), bucket_starts_.end() - 1);
+    for (Index i = 0; i < count; ++i) {
+        const CellRange& range = ranges_[i];
+        for (int row = range.first_row; row < range.end_row; ++row) {
+            for (int col = range.first_col; col < range.end_col; ++col) {
+                entries_[bucket_ends_[getBucket(row, col)]++] = i;
+            }
+        }
+    }
+
+    visit_marks_.assign(count, 0);
+    visit_mark_ = 0;
+}
+
+template <typename Visitor>
+void Broadphase::query(const Rectangle& rect, Visitor visitor)
+{
+    startQuery();
+    const CellRange range = getCellRange(rect);
+    for (int row = range.first_row; row < range.end_row; ++row) {
+        for (int col = range.first_col; col < range.end_col; ++col) {
+            const std::size_t bucket = getBucket(row, col);
+            for (std::size_t e = bucket_starts_[bucket];
+                    e < bucket_starts_[bucket + 1]; ++e) {
+                const Index body = entries_[e];
+                if (visit_marks_[body] != visit_mark_) {
+                    visit_marks_[body] = visit_mark_;
+                    visitor(body);
+                }
+            }
+        }
+    }
+}
+
+inline std::size_t Broadphase::getBucket(int row, int col) const
+{
+    const uint32_t hash = static_cast<uint32_t>(row) * 73856093u ^
+        static_cast<uint32_t>(col) * 19349663u;
+    return hash & bucket_mask_;
+}
+
+#endif /* BROADPHASE_H_ */
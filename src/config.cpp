@@ -6,4 +6,8 @@ GraphicsQuality getGraphicsQuality() {
     return GraphicsQuality::ORIGINAL;
 }
 
+std::size_t getMapMemoryBudget() {
+    return 4 * 1024 * 1024;
+}
+
 }
@@ -1,6 +1,8 @@
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+#include <cstddef>
+
 namespace config {
 
 enum class GraphicsQuality {
@@ -10,6 +12,9 @@ enum class GraphicsQuality {
 
 GraphicsQuality getGraphicsQuality();
 
+// Bytes of tile chunks a streamed Map may keep resident
+std::size_t getMapMemoryBudget();
+
 } /* namespace config */
 
 #endif /* CONFIG_H_ */
@@ -1,6 +1,7 @@
 #include <cmath>
+#include <tuple>
 #include "damage_text.h"
-#include "number_sprite.h"
+#include "savestate.h"
 
 const units::Velocity kDamageTextVelocity{-units::kHalfTile / 250};
 const std::chrono::milliseconds kDamageTime{2000};
@@ -10,7 +11,8 @@ DamageText::DamageText() :
     damage_{0},
     damage_timer_(kDamageTime),
     should_rise_{true},
-    center_pos_{0, 0}
+    center_pos_{0, 0},
+    label_(TextRenderer::Font::RED)
 {}
 
 DamageText::~DamageText() {}
@@ -35,8 +37,7 @@ void DamageText::draw(Graphics& graphics) const
     auto pos = center_pos_;
     pos.y += offset_y_;
 
-    auto nsprite = NumberSprite::DamageNumber(graphics, damage_);
-    nsprite.drawCentered(graphics, pos);
+    label_.drawCentered(graphics, pos);
 }
 
 void DamageText::setDamage(units::HP damage)
@@ -47,9 +48,43 @@ void DamageText::setDamage(units::HP damage)
     }
     damage_ += damage;
     damage_timer_.reset();
+    label_.setNumber(damage_, TextLabel::Sign::MINUS);
 }
 
 void DamageText::setCenterPosition(const Vector<units::Game> center_pos)
 {
     center_pos_ = center_pos;
 }
+
+void DamageText::clear()
+{
+    damage_ = 0;
+}
+
+void DamageText::save(StateWriter& writer) const
+{
+    writer.write(offset_y_);
+    writer.write(damage_);
+    damage_timer_.save(writer);
+    writer.write(should_rise_);
+    writer.write(center_pos_);
+}
+
+void DamageText::restore(StateReader& reader)
+{
+    reader.read(offset_y_);
+    reader.read(damage_);
+    damage_timer_.restore(reader);
+    reader.read(should_rise_);
+    reader.read(center_pos_);
+    label_.setNumber(damage_, TextLabel::Sign::MINUS);
+}
+
+bool DamageText::savesBefore(const DamageText& other) const
+{
+    return std::make_tuple(damage_timer_.current_time(), damage_,
+            center_pos_.x, center_pos_.y, offset_y_, should_rise_) <
+        std::make_tuple(other.damage_timer_.current_time(), other.damage_,
+            other.center_pos_.x, other.center_pos_.y, other.offset_y_,
+            other.should_rise_);
+}
@@ -2,11 +2,14 @@
 #define DAMAGE_TEXT_H_
 
 #include <chrono>
+#include "text_renderer.h"
 #include "timer.h"
 #include "vector.h"
 #include "units.h"
 
 struct Graphics;
+struct StateReader;
+struct StateWriter;
 
 struct DamageText {
    DamageText();
@@ -17,12 +20,22 @@ struct DamageText {
 
    void setDamage(units::HP damage);
    void setCenterPosition(const Vector<units::Game> center_pos);
+   // Forgets the damage shown, so that the next setDamage() starts a new
+   // text rising from the center
+   void clear();
+
+   void save(StateWriter& writer) const;
+   void restore(StateReader& reader);
+   // Orders texts by what save() writes, so that equal sets of texts save
+   // the same bytes whatever order they are kept in
+   bool savesBefore(const DamageText& other) const;
 private:
    units::Game offset_y_;
    units::HP damage_;
    Timer damage_timer_;
    bool should_rise_;
    Vector<units::Game> center_pos_;
+   TextLabel label_;
 };
 
 #endif /* DAMAGE_TEXT_H_ */
@@ -1,38 +1,134 @@
+#include <algorithm>
+#include <utility>
 #include "damage_texts.h"
 #include "damageable.h"
 #include "damage_text.h"
+#include "savestate.h"
+#include "trace.h"
 
-DamageTexts::DamageTexts() :
-    damage_text_map_()
-{}
+// Texts on screen at once before the lists grow
+const std::size_t kReservedTexts{64};
 
+DamageTexts::DamageTexts() :
+    texts_(),
+    spare_texts_(),
+    save_order_()
+{
+    texts_.reserve(kReservedTexts);
+    spare_texts_.reserve(kReservedTexts);
+    save_order_.reserve(kReservedTexts);
+}
 
 void DamageTexts::update(const std::chrono::milliseconds elapsed_time)
 {
-    for (auto pair : damage_text_map_) {
-        if (!pair.second.expired()) {
-            std::shared_ptr<Damageable> damageable(pair.second);
-            pair.first->setCenterPosition(damageable->getCenterPos());
+    TRACE_ZONE("DamageTexts::update");
+    for (std::size_t i = 0; i < texts_.size(); ) {
+        Entry& entry = texts_[i];
+        const std::shared_ptr<Damageable> owner = entry.owner.lock();
+        if (owner) {
+            entry.text->setCenterPosition(owner->getCenterPos());
         }
         // Owner still alive or timer is not expired - damage text still exists
-        if (pair.first->update(elapsed_time) || !pair.second.expired()) {
-            continue;
+        if (entry.text->update(elapsed_time) || owner) {
+            ++i;
         } else {
-            damage_text_map_.erase(pair.first);
+            removeText(i);
         }
     }
 }
 
 void DamageTexts::draw(Graphics& graphics) const
 {
-    for (auto pair : damage_text_map_) {
-        pair.first->draw(graphics);
+    TRACE_ZONE("DamageTexts::draw");
+    for (const auto& entry : texts_) {
+        entry.text->draw(graphics);
     }
 }
 
 void DamageTexts::addDamageable(const std::shared_ptr<Damageable> damageable)
 {
-    auto damage_text_ = damageable->getDamageText();
-    damage_text_map_[damage_text_] = std::weak_ptr<Damageable>(damageable);
+    const auto damage_text = damageable->getDamageText();
+    for (auto& entry : texts_) {
+        if (entry.text == damage_text) {
+            entry.owner = damageable;
+            return;
+        }
+    }
+    texts_.push_back(Entry{damage_text,
+            std::weak_ptr<Damageable>(damageable)});
+}
 
+void DamageTexts::addDamage(const Vector<units::Game> center_pos,
+        units::HP damage)
+{
+    auto damage_text = takeSpareText();
+    damage_text->setCenterPosition(center_pos);
+    damage_text->setDamage(damage);
+    texts_.push_back(Entry{damage_text, std::weak_ptr<Damageable>()});
+}
+
+void DamageTexts::save(StateWriter& writer) const
+{
+    // Texts are kept in the order they were added, which rollbacks and
+    // removals shuffle
+    save_order_.clear();
+    for (const auto& entry : texts_) {
+        if (entry.owner.expired()) {
+            save_order_.push_back(entry.text.get());
+        }
+    }
+    std::sort(save_order_.begin(), save_order_.end(),
+            [](const DamageText* a, const DamageText* b) {
+                return a->savesBefore(*b);
+            });
+    writer.write(save_order_.size());
+    for (const auto* damage_text : save_order_) {
+        damage_text->save(writer);
+    }
+}
+
+void DamageTexts::restore(StateReader& reader)
+{
+    std::size_t num_unowned{0};
+    reader.read(num_unowned);
+    // Restore into the unowned texts already there before taking spare ones
+    std::size_t num_restored{0};
+    for (std::size_t i = 0; i < texts_.size(); ) {
+        if (!texts_[i].owner.expired()) {
+            ++i;
+        } else if (num_restored < num_unowned) {
+            texts_[i].text->restore(reader);
+            ++num_restored;
+            ++i;
+        } else {
+            removeText(i);
+        }
+    }
+    for (; num_restored < num_unowned; ++num_restored) {
+        auto damage_text = takeSpareText();
+        damage_text->restore(reader);
+        texts_.push_back(Entry{damage_text, std::weak_ptr<Damageable>()});
+    }
+}
+
+std::shared_ptr<DamageText> DamageTexts::takeSpareText()
+{
+    if (spare_texts_.empty()) {
+        return std::make_shared<DamageText>();
+    }
+    std::shared_ptr<DamageText> damage_text = std::move(spare_texts_.back());
+    spare_texts_.pop_back();
+    return damage_text;
+}
+
+void DamageTexts::removeText(std::size_t index)
+{
+    std::shared_ptr<DamageText>& damage_text = texts_[index].text;
+    // A text left by a gone owner is only reused once nothing else holds it
+    if (damage_text.use_count() == 1) {
+        damage_text->clear();
+        spare_texts_.push_back(std::move(damage_text));
+    }
+    texts_[index] = std::move(texts_.back());
+    texts_.pop_back();
 }
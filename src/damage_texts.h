@@ -2,24 +2,47 @@
 #define DAMAGE_TEXTS_H_
 
 #include <chrono>
-#include <map>
 #include <memory>
+#include <vector>
 #include "units.h"
+#include "vector.h"
 
 struct Damageable;
 struct DamageText;
 struct Graphics;
+struct StateReader;
+struct StateWriter;
 
 struct DamageTexts {
    DamageTexts();
    void update(const std::chrono::milliseconds elapsed_time);
    void draw(Graphics& graphics) const;
    void addDamageable(const std::shared_ptr<Damageable> damageable);
+   // Shows |damage| at |center_pos| for entities that do not own a
+   // DamageText; the text stays where it was spawned.
+   void addDamage(const Vector<units::Game> center_pos, units::HP damage);
+
+   // Savestate of the texts left behind by addDamage() and by owners that
+   // are gone. Texts of live owners are part of their owners' state.
+   void save(StateWriter& writer) const;
+   void restore(StateReader& reader);
 private:
-   typedef std::map<std::shared_ptr<DamageText>, std::weak_ptr<Damageable> >
-       DamageTextMap;
+   struct Entry {
+       std::shared_ptr<DamageText> text;
+       // Expired for texts without an owner
+       std::weak_ptr<Damageable> owner;
+   };
+
+   // A text from spare_texts_, or a new one if there is none
+   std::shared_ptr<DamageText> takeSpareText();
+   // Moves the text of entry |index| to spare_texts_
+   void removeText(std::size_t index);
 
-   DamageTextMap damage_text_map_;
+   std::vector<Entry> texts_;
+   // Removed texts, reused so that damage in play does not allocate
+   std::vector<std::shared_ptr<DamageText> > spare_texts_;
+   // Reused by save()
+   mutable std::vector<const DamageText*> save_order_;
 };
 
 #endif /* DAMAGE_TEXTS_H_ */
@@ -0,0 +1,235 @@
+#include <cstring>
+#include "enemy_store.h"
+#include "savestate.h"
+#include "timer.h"
+
+namespace {
+
+// Enemies per job; a handful of them is cheaper to update inline
+const EnemyStore::Index kUpdateGrain{1024};
+
+// Moves the last element into |index| and shrinks the array
+template <typename T>
+void removeSwapped(std::vector<T>& components, EnemyStore::Index index)
+{
+    components[index] = components.back();
+    components.pop_back();
+}
+
+template <typename T>
+T load(const double* components)
+{
+    T values;
+    std::memcpy(&values, components, sizeof(T));
+    return values;
+}
+
+template <typename T>
+void store(double* components, const T values)
+{
+    std::memcpy(components, &values, sizeof(T));
+}
+
+} // anonymous namespace
+
+EnemyStore::EnemyStore() :
+    pos_x_(),
+    pos_y_(),
+    velocity_x_(),
+    velocity_y_(),
+    flight_center_y_(),
+    flight_angle_(),
+    angular_velocity_(),
+    flight_amplitude_(),
+    facing_(),
+    animation_start_(),
+    health_(),
+    contact_damage_(),
+    width_(),
+    height_()
+{}
+
+EnemyStore::Index EnemyStore::spawn(const Archetype& archetype,
+        Vector<units::Game> pos)
+{
+    pos_x_.push_back(pos.x);
+    pos_y_.push_back(pos.y);
+    velocity_x_.push_back(0.0);
+    velocity_y_.push_back(0.0);
+    flight_center_y_.push_back(pos.y);
+    flight_angle_.push_back(0.0);
+    angular_velocity_.push_back(archetype.angular_velocity);
+    flight_amplitude_.push_back(archetype.flight_amplitude);
+    facing_.push_back(HorizontalFacing::RIGHT);
+    animation_start_.push_back(Timer::now());
+    health_.push_back(archetype.health);
+    contact_damage_.push_back(archetype.contact_damage);
+    width_.push_back(archetype.width);
+    height_.push_back(archetype.height);
+    return size() - 1;
+}
+
+void EnemyStore::clear()
+{
+    *this = EnemyStore();
+}
+
+std::size_t EnemyStore::size() const
+{
+    return pos_x_.size();
+}
+
+void EnemyStore::update(const std::chrono::milliseconds elapsed_time,
+        const units::Game player_x, JobSystem& jobs)
+{
+    removeDead();
+
+    jobs.parallelFor(size(), kUpdateGrain,
+            [this, elapsed_time, player_x](Index begin, Index end) {
+                updateRange(elapsed_time, player_x, begin, end);
+            });
+}
+
+void EnemyStore::takeDamage(Index index, units::HP damage)
+{
+    health_[index] -= damage;
+}
+
+bool EnemyStore::isAlive(Index index) const
+{
+    return health_[index] > 0;
+}
+
+const Rectangle EnemyStore::getCollisionRectangle(Index index) const
+{
+    return Rectangle(pos_x_[index], pos_y_[index],
+            width_[index], height_[index]);
+}
+
+const Rectangle EnemyStore::getDamageRectangle(Index index) const
+{
+    const auto center = getCenterPos(index);
+    return Rectangle(center.x, center.y, 0, 0);
+}
+
+const Vector<units::Game> EnemyStore::getPos(Index index) const
+{
+    return Vector<units::Game>{pos_x_[index], pos_y_[index]};
+}
+
+const Vector<units::Game> EnemyStore::getCenterPos(Index index) const
+{
+    return Vector<units::Game>{
+        pos_x_[index] + width_[index] / 2,
+        pos_y_[index] + height_[index] / 2
+    };
+}
+
+units::HP EnemyStore::getContactDamage(Index index) const
+{
+    return contact_damage_[index];
+}
+
+HorizontalFacing EnemyStore::getFacing(Index index) const
+{
+    return facing_[index];
+}
+
+std::chrono::milliseconds EnemyStore::getAnimationStart(Index index) const
+{
+    return animation_start_[index];
+}
+
+void EnemyStore::save(StateWriter& writer) const
+{
+    writer.writeArray(pos_x_);
+    writer.writeArray(pos_y_);
+    writer.writeArray(velocity_x_);
+    writer.writeArray(velocity_y_);
+    writer.writeArray(flight_center_y_);
+    writer.writeArray(flight_angle_);
+    writer.writeArray(angular_velocity_);
+    writer.writeArray(flight_amplitude_);
+    writer.writeArray(facing_);
+    writer.writeArray(animation_start_);
+    writer.writeArray(health_);
+    writer.writeArray(contact_damage_);
+    writer.writeArray(width_);
+    writer.writeArray(height_);
+}
+
+void EnemyStore::restore(StateReader& reader)
+{
+    reader.readArray(pos_x_);
+    reader.readArray(pos_y_);
+    reader.readArray(velocity_x_);
+    reader.readArray(velocity_y_);
+    reader.readArray(flight_center_y_);
+    reader.readArray(flight_angle_);
+    reader.readArray(angular_velocity_);
+    reader.readArray(flight_amplitude_);
+    reader.readArray(facing_);
+    reader.readArray(animation_start_);
+    reader.readArray(health_);
+    reader.readArray(contact_damage_);
+    reader.readArray(width_);
+    reader.readArray(height_);
+}
+
+void EnemyStore::removeDead()
+{
+    for (Index i = 0; i < size(); ) {
+        if (isAlive(i)) {
+            ++i;
+            continue;
+        }
+        removeSwapped(pos_x_, i);
+        removeSwapped(pos_y_, i);
+        removeSwapped(velocity_x_, i);
+        removeSwapped(velocity_y_, i);
+        removeSwapped(flight_center_y_, i);
+        removeSwapped(flight_angle_, i);
+        removeSwapped(angular_velocity_, i);
+        removeSwapped(flight_amplitude_, i);
+        removeSwapped(facing_, i);
+        removeSwapped(animation_start_, i);
+        removeSwapped(health_, i);
+        removeSwapped(contact_damage_, i);
+        removeSwapped(width_, i);
+        removeSwapped(height_, i);
+    }
+}
+
+template <typename T>
+void EnemyStore::fly(Index i, double dt)
+{
+    const T angle = load<T>(&flight_angle_[i]) +
+        load<T>(&angular_velocity_[i]) * dt;
+    const T center = load<T>(&flight_center_y_[i]) +
+        load<T>(&velocity_y_[i]) * dt;
+    store(&flight_angle_[i], angle);
+    store(&flight_center_y_[i], center);
+    store(&pos_x_[i], load<T>(&pos_x_[i]) + load<T>(&velocity_x_[i]) * dt);
+    store(&pos_y_[i],
+            center + load<T>(&flight_amplitude_[i]) * units::sin(angle));
+}
+
+void EnemyStore::updateRange(const std::chrono::milliseconds elapsed_time,
+        const units::Game player_x, Index begin, Index end)
+{
+    const double dt = elapsed_time.count();
+    // Flight, a full set of SIMD lanes at a time, then the leftovers
+    Index first = begin;
+    for (; first + units::kNumLanes <= end; first += units::kNumLanes) {
+        fly<units::Lanes>(first, dt);
+    }
+    for (; first < end; ++first) {
+        fly<double>(first, dt);
+    }
+    // Facing
+    for (Index i = begin; i < end; ++i) {
+        facing_[i] = pos_x_[i] + width_[i] / 2 > player_x
+            ? HorizontalFacing::LEFT
+            : HorizontalFacing::RIGHT;
+    }
+}
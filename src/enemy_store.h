@@ -0,0 +1,92 @@
+#ifndef ENEMY_STORE_H_
+#define ENEMY_STORE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include "job_system.h"
+#include "rectangle.h"
+#include "sprite_state.h"
+#include "units.h"
+#include "vector.h"
+
+struct StateReader;
+struct StateWriter;
+
+// Structure-of-arrays storage for enemies: every component lives in its own
+// array indexed by enemy, and the systems in update() walk them linearly.
+// Indices are only stable within a frame; dead enemies are removed by
+// moving the last enemy into their slot.
+struct EnemyStore {
+    typedef std::size_t Index;
+
+    // What an archetype (e.g. FirstCaveBat) hands to spawn()
+    struct Archetype {
+        units::HP health;
+        units::HP contact_damage;
+        units::Game width;
+        units::Game height;
+        units::AngularVelocity angular_velocity;
+        units::Game flight_amplitude;
+    };
+
+    EnemyStore();
+
+    Index spawn(const Archetype& archetype, Vector<units::Game> pos);
+    void clear();
+    std::size_t size() const;
+
+    // Removes enemies killed since the last update, then moves the rest
+    // along their flight paths and turns them towards |player_x|. Enemies
+    // are split across |jobs|; each one only touches its own components.
+    void update(const std::chrono::milliseconds elapsed_time,
+            const units::Game player_x, JobSystem& jobs);
+
+    void takeDamage(Index index, units::HP damage);
+    bool isAlive(Index index) const;
+
+    const Rectangle getCollisionRectangle(Index index) const;
+    const Rectangle getDamageRectangle(Index index) const;
+    const Vector<units::Game> getPos(Index index) const;
+    const Vector<units::Game> getCenterPos(Index index) const;
+    units::HP getContactDamage(Index index) const;
+    HorizontalFacing getFacing(Index index) const;
+    // World time (Timer::now) at which the enemy's animation started
+    std::chrono::milliseconds getAnimationStart(Index index) const;
+
+    // Savestate of every enemy; restoring keeps the arrays' capacity
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
+
+private:
+    void removeDead();
+    void updateRange(const std::chrono::milliseconds elapsed_time,
+            const units::Game player_x, Index begin, Index end);
+    // Moves enemies [i, i + N) along their flight paths, where T holds N
+    // doubles (double or units::Lanes)
+    template <typename T>
+    void fly(Index i, double dt);
+
+    // Position
+    std::vector<units::Game> pos_x_;
+    std::vector<units::Game> pos_y_;
+    // Velocity of the flight center
+    std::vector<units::Velocity> velocity_x_;
+    std::vector<units::Velocity> velocity_y_;
+    // Flight: sinusoidal bobbing around flight_center_y_
+    std::vector<units::Game> flight_center_y_;
+    std::vector<units::Degrees> flight_angle_;
+    std::vector<units::AngularVelocity> angular_velocity_;
+    std::vector<units::Game> flight_amplitude_;
+    // Sprite state
+    std::vector<HorizontalFacing> facing_;
+    std::vector<std::chrono::milliseconds> animation_start_;
+    // Health
+    std::vector<units::HP> health_;
+    std::vector<units::HP> contact_damage_;
+    // Collision box, anchored at the position
+    std::vector<units::Game> width_;
+    std::vector<units::Game> height_;
+};
+
+#endif /* ENEMY_STORE_H_ */
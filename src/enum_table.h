@@ -0,0 +1,99 @@
+#ifndef ENUM_TABLE_H_
+#define ENUM_TABLE_H_
+
+#include <cstddef>
+#include <utility>
+
+// Number of values of an enum whose last enumerator is LAST
+template <typename E>
+constexpr std::size_t enumCount()
+{
+    return static_cast<std::size_t>(E::LAST);
+}
+
+// Dense index over every combination of values of |Enums|, with the first
+// enum varying slowest, so a table over them can be a flat array.
+template <typename... Enums>
+struct EnumIndex {
+    static constexpr std::size_t size()
+    {
+        const std::size_t counts[] = {enumCount<Enums>()...};
+        std::size_t size = 1;
+        for (std::size_t count : counts) {
+            size *= count;
+        }
+        return size;
+    }
+
+    static constexpr std::size_t get(Enums... keys)
+    {
+        const std::size_t counts[] = {enumCount<Enums>()...};
+        const std::size_t values[] = {static_cast<std::size_t>(keys)...};
+        std::size_t index = 0;
+        for (std::size_t i = 0; i < sizeof...(Enums); ++i) {
+            index = index * counts[i] + values[i];
+        }
+        return index;
+    }
+
+    // Distance between indices that differ by one in the key at |position|
+    static constexpr std::size_t stride(std::size_t position)
+    {
+        const std::size_t counts[] = {enumCount<Enums>()...};
+        std::size_t stride = 1;
+        for (std::size_t i = position + 1; i < sizeof...(Enums); ++i) {
+            stride *= counts[i];
+        }
+        return stride;
+    }
+};
+
+// Flat array holding one T per combination of |Enums|. It is an aggregate,
+// so tables of literal types can be built at compile time with
+// makeEnumTable.
+template <typename T, typename... Enums>
+struct EnumTable {
+    typedef EnumIndex<Enums...> Index;
+
+    static constexpr std::size_t size() { return Index::size(); }
+
+    constexpr T& operator()(Enums... keys)
+    {
+        return values[Index::get(keys...)];
+    }
+    constexpr const T& operator()(Enums... keys) const
+    {
+        return values[Index::get(keys...)];
+    }
+
+    T values[Index::size()];
+};
+
+namespace detail {
+
+template <typename T, typename... Enums, typename Generator,
+        std::size_t... Position>
+constexpr EnumTable<T, Enums...> makeEnumTable(Generator generate,
+        std::index_sequence<Position...>)
+{
+    typedef EnumIndex<Enums...> Index;
+    EnumTable<T, Enums...> table{};
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table.values[i] = generate(static_cast<Enums>(
+                    i / Index::stride(Position) % enumCount<Enums>())...);
+    }
+    return table;
+}
+
+} // namespace detail
+
+// Table holding generate(keys...) for every combination of keys. Pass a
+// constexpr function to build it at compile time.
+template <typename T, typename... Enums, typename Generator>
+constexpr EnumTable<T, Enums...> makeEnumTable(Generator generate)
+{
+    return detail::makeEnumTable<T, Enums...>(generate,
+            std::index_sequence_for<Enums...>{});
+}
+
+#endif /* ENUM_TABLE_H_ */
@@ -1,115 +1,64 @@
-#include <string>
-#include "animated_sprite.h"
 #include "first_cave_bat.h"
+#include "animation.h"
 #include "graphics.h"
 
-const units::Frame kNumFlyFrames{3};
-const units::FPS kFlyFps{13};
 const units::AngularVelocity kAngularVelocity{120.0 / 1000.0};
 const units::Game kFlightAmplitude{5 * units::kHalfTile};
 
-const std::string kSpritePath{"NpcCemet"};
-
+const units::HP kHealth{1};
 const units::HP kContactDamage{1};
 
-FirstCaveBat::FirstCaveBat(Graphics& graphics, Vector<units::Game> pos) :
-    pos_(std::move(pos)),
-    flight_center_y_{pos_.y},
-    alive_{true},
-    facing_{HorizontalFacing::RIGHT},
-    flight_angle_{0.0},
-    sprites_(),
-    damage_text_(std::make_shared<DamageText>())
-{
-    initializeSprites(graphics);
-}
+const EnemyStore::Archetype FirstCaveBat::kArchetype{
+    kHealth,
+    kContactDamage,
+    units::tileToGame(1),
+    units::tileToGame(1),
+    kAngularVelocity,
+    kFlightAmplitude
+};
 
-FirstCaveBat::~FirstCaveBat() {}
+namespace {
 
-void FirstCaveBat::draw(Graphics& graphics) const
+ClipId getFlyClip(HorizontalFacing facing)
 {
-    sprites_.at(getSpriteState())->draw(graphics, pos_);
+    return (facing == HorizontalFacing::RIGHT)
+        ? ClipId::FIRST_CAVE_BAT_FLY_RIGHT
+        : ClipId::FIRST_CAVE_BAT_FLY_LEFT;
 }
 
-bool FirstCaveBat::update(const std::chrono::milliseconds elapsed_time,
-        const units::Game player_x)
-{
-    flight_angle_ += kAngularVelocity * elapsed_time.count();
-
-    facing_ = pos_.x + units::kHalfTile > player_x
-        ? HorizontalFacing::LEFT
-        : HorizontalFacing::RIGHT;
+} // anonymous namespace
 
-    const auto angle = std::sin(units::degreesToRadians(flight_angle_));
-    pos_.y = flight_center_y_ + kFlightAmplitude * units::Game(angle);
-    sprites_[getSpriteState()]->update();
-    return alive_;
-}
-
-const Rectangle FirstCaveBat::getDamageRectangle() const
+FirstCaveBat::FirstCaveBat(Graphics& graphics) :
+    sprites_()
 {
-    return Rectangle(
-            pos_.x + units::kHalfTile,
-            pos_.y + units::kHalfTile,
-            0,
-            0);
+    initializeSprites(graphics);
 }
 
-const Rectangle FirstCaveBat::getCollisionRectangle() const
-{
-    return Rectangle( pos_.x,
-            pos_.y,
-            units::tileToGame(1),
-            units::tileToGame(1)
-            );
-}
+FirstCaveBat::~FirstCaveBat() {}
 
-units::HP FirstCaveBat::contactDamage() const
+EnemyStore::Index FirstCaveBat::spawn(EnemyStore& enemies,
+        Vector<units::Game> pos)
 {
-    return kContactDamage;
+    return enemies.spawn(kArchetype, pos);
 }
 
-void FirstCaveBat::takeDamage(units::HP damage)
+void FirstCaveBat::draw(Graphics& graphics, const EnemyStore& enemies) const
 {
-    damage_text_->setDamage(damage);
-    alive_ = false;
+    const SpriteRegistry& sprites = graphics.getSpriteRegistry();
+    for (EnemyStore::Index i = 0; i < enemies.size(); ++i) {
+        const HorizontalFacing facing = enemies.getFacing(i);
+        const Animation animation{getFlyClip(facing),
+            enemies.getAnimationStart(i)};
+        sprites.draw(static_cast<SpriteRegistry::Id>(
+                    sprites_(facing) + animation.getFrame()),
+                enemies.getPos(i));
+    }
 }
 
 void FirstCaveBat::initializeSprites(Graphics& graphics)
 {
     for (auto hf = HorizontalFacing::FIRST; hf != HorizontalFacing::LAST; ++hf) {
-        initializeSprite(graphics, SpriteState(hf));
+        sprites_(hf) = addClipSprites(graphics.getSpriteRegistry(),
+                getFlyClip(hf));
     }
 }
-
-void FirstCaveBat::initializeSprite(Graphics& graphics,
-        const SpriteState& sprite_state)
-{
-    auto tile_y = sprite_state.facing == HorizontalFacing::RIGHT ? 3 : 2;
-    sprites_[sprite_state] = std::make_shared<AnimatedSprite>(
-            graphics,
-            kSpritePath,
-            units::tileToPixel(2), units::tileToPixel(tile_y),
-            units::tileToPixel(1), units::tileToPixel(1),
-            kFlyFps, kNumFlyFrames
-            );
-}
-
-const FirstCaveBat::SpriteState FirstCaveBat::getSpriteState() const
-{
-    return SpriteState(facing_);
-}
-
-const Vector<units::Game> FirstCaveBat::getCenterPos() const
-{
-    return Vector<units::Game> {
-        pos_.x + units::kHalfTile,
-        pos_.y + units::kHalfTile
-    };
-
-}
-
-const std::shared_ptr<DamageText> FirstCaveBat::getDamageText() const
-{
-    return damage_text_;
-}
@@ -1,54 +1,33 @@
 #ifndef FIRST_CAVE_BAT_H_
 #define FIRST_CAVE_BAT_H_
 
-#include <chrono>
-#include "damageable.h"
-#include "damage_text.h"
-#include "vector.h"
-#include "units.h"
-#include "rectangle.h"
+#include "enemy_store.h"
+#include "enum_table.h"
+#include "sprite_registry.h"
 #include "sprite_state.h"
+#include "units.h"
+#include "vector.h"
 
-struct Sprite;
 struct Graphics;
 
-struct FirstCaveBat : public Damageable {
-   FirstCaveBat(Graphics& graphics, Vector<units::Game> pos);
+// Archetype of the bats bobbing up and down in the first cave. The state of
+// every bat lives in an EnemyStore; this only holds what they all share.
+struct FirstCaveBat {
+   FirstCaveBat(Graphics& graphics);
    ~FirstCaveBat();
 
-   void draw(Graphics& graphics) const;
-   bool update(const std::chrono::milliseconds elapsed_time,
-           const units::Game player_x);
-
-   const Rectangle getDamageRectangle() const;
-   const Rectangle getCollisionRectangle() const;
+   static EnemyStore::Index spawn(EnemyStore& enemies,
+           Vector<units::Game> pos);
 
-   units::HP contactDamage() const;
-   void takeDamage(units::HP damage);
+   void draw(Graphics& graphics, const EnemyStore& enemies) const;
 
 private:
-   struct SpriteState {
-       SpriteState(HorizontalFacing facing) : facing{facing} {}
-       HorizontalFacing facing;
-   };
-   friend bool operator<(const SpriteState& a, const SpriteState& b) {
-       return a.facing < b.facing;
-   }
+   static const EnemyStore::Archetype kArchetype;
 
    void initializeSprites(Graphics& graphics);
-   void initializeSprite(Graphics& graphics, const SpriteState& sprite_state);
-   const SpriteState getSpriteState() const;
-
-   const Vector<units::Game> getCenterPos() const override;
-   const std::shared_ptr<DamageText> getDamageText() const override;
-
-   Vector<units::Game> pos_;
-   const units::Game flight_center_y_;
-   bool alive_;
-   HorizontalFacing facing_;
-   units::Degrees flight_angle_;
-   std::map<SpriteState, std::shared_ptr<Sprite> > sprites_;
-   std::shared_ptr<DamageText> damage_text_;
+
+   // First sprite of the fly clip for each facing
+   EnumTable<SpriteRegistry::Id, HorizontalFacing> sprites_;
 };
 
 #endif /* FIRST_CAVE_BAT_H_ */
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "frame_capture.h"
+#include "trace.h"
+
+namespace {
+
+// How long the encoder sleeps when it has caught up
+const std::chrono::milliseconds kIdleWait{1};
+
+bool endsWith(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() &&
+        text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// BT.601 limited range, as players expect from Y4M
+unsigned char toY(int r, int g, int b)
+{
+    return static_cast<unsigned char>(
+        ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+unsigned char toU(int r, int g, int b)
+{
+    return static_cast<unsigned char>(
+        ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+unsigned char toV(int r, int g, int b)
+{
+    return static_cast<unsigned char>(
+        ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+} // anonymous namespace
+
+CaptureConfig::CaptureConfig() :
+    file_path(),
+    first_frame{0},
+    num_frames{0}
+{}
+
+FrameCapture::FrameCapture(const std::string& file_path, int width,
+        int height, units::FPS fps, bool drop_when_full) :
+    file_path_(file_path),
+    format_{endsWith(file_path, ".y4m") ? Format::Y4M : Format::PNG},
+    width_{width},
+    height_{height},
+    drop_when_full_{drop_when_full},
+    slots_(kQueueSize, std::vector<unsigned char>(
+                static_cast<std::size_t>(width) * height * 4)),
+    queued_{0},
+    encoded_{0},
+    stopping_{false},
+    failed_{false},
+    dropped_{0},
+    stream_(),
+    planes_(),
+    encoder_()
+{
+    if (format_ == Format::Y4M) {
+        stream_.open(file_path, std::ios::binary);
+        if (!stream_) {
+            throw std::runtime_error(
+                "Cannot write capture '" + file_path + "'");
+        }
+        stream_ << "YUV4MPEG2 W" << width_ << " H" << height_ << " F" << fps
+            << ":1 Ip A1:1 C420jpeg\n";
+        const std::size_t chroma_size =
+            static_cast<std::size_t>((width_ + 1) / 2) * ((height_ + 1) / 2);
+        planes_.resize(static_cast<std::size_t>(width_) * height_ +
+                2 * chroma_size);
+    }
+    encoder_ = std::thread(&FrameCapture::runEncoder, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+    if (encoder_.joinable()) {
+        stopping_.store(true, std::memory_order_release);
+        encoder_.join();
+    }
+}
+
+int FrameCapture::getWidth() const
+{
+    return width_;
+}
+
+int FrameCapture::getHeight() const
+{
+    return height_;
+}
+
+int FrameCapture::getPitch() const
+{
+    return width_ * 4;
+}
+
+unsigned char* FrameCapture::beginFrame()
+{
+    if (failed_.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("Cannot write capture '" + file_path_ + "'");
+    }
+    const uint64_t frame = queued_.load(std::memory_order_relaxed);
+    while (frame - encoded_.load(std::memory_order_acquire) == kQueueSize) {
+        if (drop_when_full_) {
+            ++dropped_;
+            return nullptr;
+        }
+        std::this_thread::yield();
+    }
+    return slots_[frame % kQueueSize].data();
+}
+
+void FrameCapture::endFrame()
+{
+    // Publishes the pixels along with the count
+    queued_.store(queued_.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+}
+
+void FrameCapture::finish()
+{
+    if (encoder_.joinable()) {
+        stopping_.store(true, std::memory_order_release);
+        encoder_.join();
+    }
+    if (format_ == Format::Y4M) {
+        stream_.close();
+    }
+    if (failed_.load(std::memory_order_relaxed) ||
+            (format_ == Format::Y4M && stream_.fail())) {
+        throw std::runtime_error("Cannot write capture '" + file_path_ + "'");
+    }
+}
+
+void FrameCapture::report(std::ostream& out) const
+{
+    out << "capture: " << encoded_.load(std::memory_order_acquire)
+        << " frames written to '" << file_path_ << "', " << dropped_
+        << " dropped\n";
+}
+
+void FrameCapture::runEncoder()
+{
+    trace::setThreadName("frame capture");
+    while (true) {
+        const uint64_t frame = encoded_.load(std::memory_order_relaxed);
+        // Reads stopping_ first: frames queued before it was set are then
+        // visible below, so none is left behind
+        const bool stopping = stopping_.load(std::memory_order_acquire);
+        if (frame == queued_.load(std::memory_order_acquire)) {
+            if (stopping) {
+                return;
+            }
+            std::this_thread::sleep_for(kIdleWait);
+            continue;
+        }
+        if (!failed_.load(std::memory_order_relaxed)) {
+            encode(slots_[frame % kQueueSize].data(), frame);
+        }
+        // Hands the slot back to the game thread
+        encoded_.store(frame + 1, std::memory_order_release);
+    }
+}
+
+void FrameCapture::encode(const unsigned char* pixels, uint64_t frame)
+{
+    TRACE_ZONE("FrameCapture::encode");
+    if (format_ == Format::Y4M) {
+        writeY4m(pixels);
+    } else {
+        writePng(pixels, frame);
+    }
+}
+
+void FrameCapture::writePng(const unsigned char* pixels, uint64_t frame)
+{
+    const std::size_t extension = endsWith(file_path_, ".png")
+        ? file_path_.size() - 4 : file_path_.size();
+    char number[24];
+    std::snprintf(number, sizeof(number), "%06llu",
+            static_cast<unsigned long long>(frame));
+    const std::string frame_path = file_path_.substr(0, extension) + number +
+        ".png";
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+            const_cast<unsigned char*>(pixels), width_, height_, 32,
+            getPitch(), SDL_PIXELFORMAT_ARGB8888);
+    if (surface == nullptr || IMG_SavePNG(surface, frame_path.c_str()) != 0) {
+        failed_.store(true, std::memory_order_relaxed);
+    }
+    SDL_FreeSurface(surface);
+}
+
+void FrameCapture::writeY4m(const unsigned char* pixels)
+{
+    const int chroma_width = (width_ + 1) / 2;
+    const int chroma_height = (height_ + 1) / 2;
+    unsigned char* y_plane = planes_.data();
+    unsigned char* u_plane = y_plane +
+        static_cast<std::size_t>(width_) * height_;
+    unsigned char* v_plane = u_plane +
+        static_cast<std::size_t>(chroma_width) * chroma_height;
+
+    const auto pixelAt = [this, pixels](int x, int y) {
+        x = std::min(x, width_ - 1);
+        y = std::min(y, height_ - 1);
+        return reinterpret_cast<const uint32_t*>(
+                pixels + static_cast<std::size_t>(y) * getPitch())[x];
+    };
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const uint32_t pixel = pixelAt(x, y);
+            y_plane[y * width_ + x] = toY((pixel >> 16) & 0xff,
+                    (pixel >> 8) & 0xff, pixel & 0xff);
+        }
+    }
+    // Chroma is the average of each 2x2 block
+    for (int y = 0; y < chroma_height; ++y) {
+        for (int x = 0; x < chroma_width; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; ++i) {
+                const uint32_t pixel = pixelAt(2 * x + i % 2, 2 * y + i / 2);
+                r += (pixel >> 16) & 0xff;
+                g += (pixel >> 8) & 0xff;
+                b += pixel & 0xff;
+            }
+            u_plane[y * chroma_width + x] = toU(r / 4, g / 4, b / 4);
+            v_plane[y * chroma_width + x] = toV(r / 4, g / 4, b / 4);
+        }
+    }
+    stream_ << "FRAME\n";
+    stream_.write(reinterpret_cast<const char*>(planes_.data()),
+            planes_.size());
+    if (!stream_) {
+        failed_.store(true, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef FRAME_CAPTURE_H_
+#define FRAME_CAPTURE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <vector>
+#include "units.h"
+
+// Writes presented frames from a thread of its own. The game thread reads
+// each frame into a free slot of a single-producer single-consumer ring
+// and moves on; the encoder takes slots from the other end. Neither side
+// locks, and slots are allocated up front, so capturing a frame costs the
+// game thread one copy of the pixels.
+//
+// A file path ending in ".y4m" gets one raw YUV 4:2:0 stream, which ffmpeg
+// and most players read directly; any other path is a PNG sequence with
+// the frame number before the extension ("shot.png" writes shot000000.png,
+// shot000001.png, ...).
+struct FrameCapture {
+    enum class Format {
+        PNG,
+        Y4M
+    };
+
+    // Frames read but not yet encoded
+    static const std::size_t kQueueSize{8};
+
+    // Frames are |width| x |height| ARGB8888 pixels. If |drop_when_full|,
+    // frames arriving while the encoder is behind are dropped instead of
+    // waited for, so that play never stalls. Throws std::runtime_error if
+    // the stream cannot be opened.
+    FrameCapture(const std::string& file_path, int width, int height,
+            units::FPS fps, bool drop_when_full);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&)=delete;
+    FrameCapture& operator=(const FrameCapture&)=delete;
+
+    int getWidth() const;
+    int getHeight() const;
+    // Bytes per row of the buffers beginFrame() returns
+    int getPitch() const;
+
+    // The buffer to read the next frame into, or nullptr if the frame is
+    // dropped. Every buffer returned must be passed on with endFrame().
+    unsigned char* beginFrame();
+    void endFrame();
+
+    // Encodes the frames still queued and stops the encoder. Throws
+    // std::runtime_error if a frame could not be written.
+    void finish();
+    // Frames written, dropped and where, once finished
+    void report(std::ostream& out) const;
+
+private:
+    void runEncoder();
+    void encode(const unsigned char* pixels, uint64_t frame);
+    void writePng(const unsigned char* pixels, uint64_t frame);
+    void writeY4m(const unsigned char* pixels);
+
+    const std::string file_path_;
+    const Format format_;
+    const int width_;
+    const int height_;
+    const bool drop_when_full_;
+
+    std::vector<std::vector<unsigned char> > slots_;
+    // Frames ever queued and ever encoded; slot i % kQueueSize holds frame
+    // i. Only the game thread writes queued_ and only the encoder encoded_.
+    std::atomic<uint64_t> queued_;
+    std::atomic<uint64_t> encoded_;
+    std::atomic<bool> stopping_;
+    // Set by the encoder when a frame could not be written
+    std::atomic<bool> failed_;
+    uint64_t dropped_;
+
+    // Encoder thread only
+    std::ofstream stream_;
+    std::vector<unsigned char> planes_;
+
+    std::thread encoder_;
+};
+
+// What Game(const CaptureConfig&) and Game(const Replay&,
+// const CaptureConfig&) capture
+struct CaptureConfig {
+    CaptureConfig();
+
+    std::string file_path;
+    // Frames of a replay to capture; 0 frames goes on to the end
+    units::Frame first_frame;
+    units::Frame num_frames;
+};
+
+#endif /* FRAME_CAPTURE_H_ */
@@ -1,47 +1,36 @@
 #include "player.h"
 
 #include "damage_texts.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include "first_cave_bat.h"
 #include "game.h"
 #include "input.h"
+#include "latency_tracker.h"
 #include "map.h"
 #include "particle_tools.h"
 #include "projectile.h"
+#include "rectangle.h"
+#include "savestate.h"
 #include "timer.h"
+#include "trace.h"
 
 const units::FPS kFps{60};
 const auto kMaxFrameTime = std::chrono::milliseconds{5 * 1000 / 60};
+const auto kFrameTime = std::chrono::milliseconds{1000 / kFps};
+// Ticks in a row a netplay session may wait for its peer before giving up
+const units::Frame kMaxNetplayWaits{600};
 units::Tile Game::kScreenWidth{20};
 units::Tile Game::kScreenHeight{15};
 
-#define BUTTON_DPAD_UP 13
-#define BUTTON_DPAD_DOWN 15
-#define BUTTON_DPAD_LEFT 12
-#define BUTTON_DPAD_RIGHT 14
-#define BUTTON_PLUS 10
-#define BUTTON_A 0
-#define BUTTON_B 1
-#define BUTTON_X 2
-#define BUTTON_Y 3
+namespace {
 
-Game::Game() :
-    sdlEngine_(),
-    graphics_(),
-    player_{std::make_shared<Player>(graphics_,
-            Vector<units::Game>{
-            units::tileToGame(Game::kScreenWidth/2),
-            units::tileToGame(Game::kScreenHeight/2)}
-            )
-    },
-    bat_{std::make_shared<FirstCaveBat>(graphics_,
-            Vector<units::Game>{
-            units::tileToGame(7),
-            units::tileToGame(Game::kScreenHeight/2 + 1)}
-            )
-    },
-    map_{Map::createTestMap(graphics_)},
-    particle_system_{},
-    damage_texts_()
+void openJoysticks()
 {
     // open CONTROLLER_PLAYER_1 and CONTROLLER_PLAYER_2
     // when connected, both joycons are mapped to joystick #0,
@@ -53,156 +42,789 @@ Game::Game() :
             SDL_Quit();
         }
     }
-    
-    runEventLoop();
+}
+
+// Hands joystick events to |input|; returns false once the window closes
+bool pollEvents(Input& input)
+{
+    SDL_Event event;
+    bool running{true};
+    while (SDL_PollEvent(&event)) {
+        switch (event.type) {
+        case SDL_JOYBUTTONDOWN:
+            input.keyDownEvent(event);
+            break;
+        case SDL_JOYBUTTONUP:
+            input.keyUpEvent(event);
+            break;
+        case SDL_QUIT:
+            running = false;
+            break;
+        default:
+            break;
+        }
+    }
+    return running;
+}
+
+// Sleeps until the next tick of a fixed rate loop. Ticks that run late
+// start the next one right away rather than trying to catch up.
+struct FramePacer {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    explicit FramePacer(std::chrono::milliseconds frame_time) :
+        frame_time_{frame_time},
+        next_frame_time_{Clock::now()}
+    {}
+
+    void wait()
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        const auto start_time = Clock::now();
+        if (next_frame_time_ > start_time) {
+            SDL_Delay(duration_cast<milliseconds>(
+                        next_frame_time_ - start_time).count());
+        }
+        next_frame_time_ = std::max(next_frame_time_, start_time) + frame_time_;
+    }
+
+private:
+    const std::chrono::milliseconds frame_time_;
+    Clock::time_point next_frame_time_;
+};
+
+} // anonymous namespace
+
+Game::Game() :
+    Game(Graphics::Output::WINDOW, SDL_INIT_VIDEO | SDL_INIT_JOYSTICK,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            std::random_device{}())
+{
+    spawnTestBat();
+    openJoysticks();
+    runEventLoop(nullptr);
+}
+
+Game::Game(const Scenario& scenario) :
+    Game(Graphics::Output::OFFSCREEN, 0, scenario.player, scenario.seed)
+{
+    runScenario(scenario);
+}
+
+Game::Game(const NetplayConfig& config) :
+    Game(Graphics::Output::WINDOW, SDL_INIT_VIDEO | SDL_INIT_JOYSTICK,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            config.seed)
+{
+    addPlayer(Vector<units::Tile>{kScreenWidth / 2 + 1, kScreenHeight / 2});
+    local_player_ = config.local_player;
+    spawnTestBat();
+    openJoysticks();
+    runNetplayLoop(config);
+}
+
+Game::Game(const RecordConfig& config) :
+    Game(config.bot_frames > 0
+            ? Graphics::Output::OFFSCREEN : Graphics::Output::WINDOW,
+            config.bot_frames > 0 ? 0 : SDL_INIT_VIDEO | SDL_INIT_JOYSTICK,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            config.seed)
+{
+    spawnTestBat();
+    Replay replay(config.seed, config.keyframe_interval);
+    if (config.bot_frames > 0) {
+        runBotRecording(config, replay);
+    } else {
+        openJoysticks();
+        runEventLoop(&replay);
+    }
+    replay.save(config.file_path);
+    std::cout << "replay: " << replay.getNumFrames() << " frames in "
+        << replay.getNumSegments() << " segments saved to '"
+        << config.file_path << "'\n";
+}
+
+Game::Game(const Replay& replay, const SeekBenchmark& benchmark) :
+    // Same world as a recording; the keyframes hold everything else
+    Game(Graphics::Output::OFFSCREEN, 0,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            replay.getSeed())
+{
+    runSeekBenchmark(replay, benchmark);
+}
+
+Game::Game(const CaptureConfig& config) :
+    Game(Graphics::Output::WINDOW, SDL_INIT_VIDEO | SDL_INIT_JOYSTICK,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            std::random_device{}())
+{
+    spawnTestBat();
+    openJoysticks();
+    startCapture(config.file_path, true);
+    runEventLoop(nullptr);
+    finishCapture();
+}
+
+Game::Game(const Replay& replay, const CaptureConfig& config) :
+    Game(Graphics::Output::OFFSCREEN, 0,
+            Vector<units::Tile>{kScreenWidth / 2, kScreenHeight / 2},
+            replay.getSeed())
+{
+    // Checked before the capture file is created
+    if (config.first_frame >= replay.getNumFrames()) {
+        throw std::runtime_error("Cannot capture from frame " +
+                std::to_string(config.first_frame) + " of a replay of " +
+                std::to_string(replay.getNumFrames()) + " frames");
+    }
+    startCapture(config.file_path, false);
+    runReplayCapture(replay, config);
+    finishCapture();
+}
+
+Game::Game(Graphics::Output output, Uint32 sdl_subsystems,
+        Vector<units::Tile> player_tile, uint64_t seed) :
+    sdlEngine_(sdl_subsystems),
+    graphics_(output),
+    jobs_(),
+    random_(seed),
+    players_(),
+    local_player_{0},
+    enemies_(),
+    first_cave_bat_(graphics_),
+    enemy_grid_(),
+    map_{Map::createTestMap(graphics_)},
+    particle_system_(graphics_),
+    damage_texts_(),
+    timings_(),
+    allocations_(),
+    rollback_states_(),
+    netplay_stats_(),
+    hash_state_(),
+    frame_capture_()
+{
+    addPlayer(player_tile);
 }
 
 Game::~Game()
 {
 }
 
-void Game::runEventLoop() {
+void Game::addPlayer(Vector<units::Tile> tile)
+{
+    players_.push_back(std::make_shared<Player>(graphics_,
+                Vector<units::Game>{
+                units::tileToGame(tile.x),
+                units::tileToGame(tile.y)}));
+}
+
+void Game::spawnTestBat()
+{
+    FirstCaveBat::spawn(enemies_, Vector<units::Game>{
+            units::tileToGame(7),
+            units::tileToGame(Game::kScreenHeight/2 + 1)});
+}
+
+void Game::runEventLoop(Replay* replay) {
     Input input;
-    SDL_Event event;
+    LatencyTracker latency;
 
-    damage_texts_.addDamageable(player_);
-    damage_texts_.addDamageable(bat_);
+    damage_texts_.addDamageable(players_[0]);
 
     bool running{true};
-    auto last_updated_time = std::chrono::high_resolution_clock::now();
+    FramePacer pacer(kFrameTime);
     while (running) {
-        using std::chrono::high_resolution_clock;
-        using std::chrono::milliseconds;
-        using std::chrono::duration_cast;
+        // Wait for the frame first and poll after, so the input is latched
+        // right before the update that consumes it instead of before a
+        // frame's worth of waiting
+        pacer.wait();
+        TRACE_ZONE("frame");
+        AllocationTracker::Scope frame_allocations(allocations_);
+        running = pollEvents(input);
+        const InputFrame input_frame = input.latch();
+        if (input_frame.wasPressed(BUTTON_PLUS)) {
+            running = false;
+        }
+        if (replay && replay->needsKeyframe()) {
+            saveState(replay->addKeyframe());
+        }
+        applyInput(*players_[0], input_frame);
 
-        const auto start_time = high_resolution_clock::now();
-
-        input.beginNewFrame();
-        while (SDL_PollEvent(&event)) {
-            switch (event.type) {
-            case SDL_JOYBUTTONDOWN:
-                input.keyDownEvent(event);
-                break;
-            case SDL_JOYBUTTONUP:
-                input.keyUpEvent(event);
-                break;
-            case SDL_QUIT:
-                running = false;
-                break;
-            default:
-                break;
+        latency.startUpdate(input.getFirstEventTime(), SDL_GetTicks());
+        update(kFrameTime, graphics_);
+        draw(graphics_);
+        latency.presented(SDL_GetTicks());
+        if (replay) {
+            replay->addFrame(input_frame, getStateHash());
+        }
+    }
+    if (replay) {
+        saveState(replay->finish());
+    }
+    if (latency.size() > 0) {
+        latency.report(std::cout);
+    }
+    allocations_.report(std::cout);
+}
+
+void Game::runBotRecording(const RecordConfig& config, Replay& replay)
+{
+    InputBot bot(Rng(config.seed).split(1));
+    damage_texts_.addDamageable(players_[0]);
+    for (units::Frame frame = 0; frame < config.bot_frames; ++frame) {
+        if (replay.needsKeyframe()) {
+            saveState(replay.addKeyframe());
+        }
+        const InputFrame input_frame = bot.next();
+        applyInput(*players_[0], input_frame);
+        update(kFrameTime, graphics_);
+        replay.addFrame(input_frame, getStateHash());
+    }
+    saveState(replay.finish());
+}
+
+void Game::runSeekBenchmark(const Replay& replay,
+        const SeekBenchmark& benchmark)
+{
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+    using std::chrono::high_resolution_clock;
+
+    damage_texts_.addDamageable(players_[0]);
+    const units::Frame interval = replay.getKeyframeInterval();
+    const units::Frame num_segments = replay.getNumSegments();
+    std::cout << "replay: " << replay.getNumFrames() << " frames, "
+        << num_segments << " segments of " << interval << " frames\n";
+
+    // Every segment starts from its own keyframe, so any range of them can
+    // be checked apart from the rest
+    const units::Frame first_segment =
+        std::min(benchmark.first_segment, num_segments);
+    const units::Frame end_segment = (benchmark.num_segments == 0)
+        ? num_segments
+        : std::min(num_segments, first_segment + benchmark.num_segments);
+    std::size_t num_mismatched{0};
+    SaveState check;
+    const auto verify_start = high_resolution_clock::now();
+    for (units::Frame segment = first_segment; segment < end_segment;
+            ++segment) {
+        restoreState(replay.getKeyframe(segment));
+        const units::Frame end = std::min((segment + 1) * interval,
+                replay.getNumFrames());
+        bool diverged{false};
+        for (units::Frame frame = segment * interval;
+                frame < end && !diverged; ++frame) {
+            replayFrame(replay, frame);
+            if (getStateHash() != replay.getHash(frame)) {
+                std::cout << "replay: frame " << frame
+                    << " diverges from the recording\n";
+                diverged = true;
+            }
+        }
+        if (!diverged) {
+            saveState(check);
+            const SaveState& expected = (segment + 1 < num_segments)
+                ? replay.getKeyframe(segment + 1) : replay.getFinalState();
+            if (check.bytes != expected.bytes) {
+                std::cout << "replay: segment " << segment
+                    << " does not end on the next keyframe\n";
+                diverged = true;
             }
         }
-        if (input.wasKeyPressed(BUTTON_PLUS)) {
+        if (diverged) {
+            ++num_mismatched;
+        }
+    }
+    const Milliseconds verify_time =
+        high_resolution_clock::now() - verify_start;
+    std::cout << "verify: segments " << first_segment << " to "
+        << end_segment << " in " << verify_time.count() << " ms, "
+        << num_mismatched << " mismatched" << std::endl;
+    if (num_mismatched > 0) {
+        throw std::runtime_error("Replay diverges from its recording");
+    }
+
+    Rng random(benchmark.seed);
+    Milliseconds total{0};
+    Milliseconds worst{0};
+    uint64_t resimulated{0};
+    for (std::size_t i = 0; i < benchmark.num_seeks; ++i) {
+        const units::Frame frame = random.between(0, replay.getNumFrames());
+        const auto start = high_resolution_clock::now();
+        seek(replay, frame);
+        const Milliseconds elapsed = high_resolution_clock::now() - start;
+        total += elapsed;
+        worst = std::max(worst, elapsed);
+        if (frame < replay.getNumFrames()) {
+            resimulated += frame % interval;
+        }
+    }
+    if (benchmark.num_seeks > 0) {
+        std::cout << "seek: " << benchmark.num_seeks << " seeks, "
+            << total.count() / benchmark.num_seeks << " ms average, "
+            << worst.count() << " ms worst, "
+            << static_cast<double>(resimulated) / benchmark.num_seeks
+            << " frames simulated on average\n";
+    }
+}
+
+uint64_t Game::getStateHash()
+{
+    saveState(hash_state_);
+    return hashState(hash_state_);
+}
+
+void Game::seek(const Replay& replay, units::Frame frame)
+{
+    if (frame >= replay.getNumFrames()) {
+        restoreState(replay.getFinalState());
+        return;
+    }
+    const units::Frame interval = replay.getKeyframeInterval();
+    restoreState(replay.getKeyframe(frame / interval));
+    for (units::Frame i = frame - frame % interval; i < frame; ++i) {
+        replayFrame(replay, i);
+    }
+}
+
+void Game::replayFrame(const Replay& replay, units::Frame frame)
+{
+    applyInput(*players_[0], replay.getInput(frame));
+    update(kFrameTime, graphics_);
+}
+
+void Game::runReplayCapture(const Replay& replay, const CaptureConfig& config)
+{
+    damage_texts_.addDamageable(players_[0]);
+    // Compared against the frames left, as first + num could wrap
+    const units::Frame frames_left =
+        replay.getNumFrames() - config.first_frame;
+    const units::Frame end_frame =
+        (config.num_frames > 0 && config.num_frames < frames_left)
+        ? config.first_frame + config.num_frames
+        : replay.getNumFrames();
+    seek(replay, config.first_frame);
+    for (units::Frame frame = config.first_frame; frame < end_frame; ++frame) {
+        TRACE_ZONE("frame");
+        AllocationTracker::Scope frame_allocations(allocations_);
+        replayFrame(replay, frame);
+        draw(graphics_);
+        if (getStateHash() != replay.getHash(frame)) {
+            throw std::runtime_error("Replay diverges at frame " +
+                    std::to_string(frame));
+        }
+    }
+    std::cout << "replay: frames " << config.first_frame << " to "
+        << end_frame << " of "
+        << replay.getNumFrames() << " replayed\n";
+    allocations_.report(std::cout);
+}
+
+void Game::startCapture(const std::string& file_path, bool drop_when_full)
+{
+    frame_capture_ = std::make_unique<FrameCapture>(file_path,
+            graphics_.getOutputWidth(), graphics_.getOutputHeight(), kFps,
+            drop_when_full);
+    graphics_.setFrameCapture(frame_capture_.get());
+}
+
+void Game::finishCapture()
+{
+    graphics_.setFrameCapture(nullptr);
+    frame_capture_->finish();
+    frame_capture_->report(std::cout);
+}
+
+void Game::runNetplayLoop(const NetplayConfig& config)
+{
+    NetplayConnection connection(config);
+    RollbackSession& session = connection.getSession();
+    Input input;
+    for (const auto& player : players_) {
+        damage_texts_.addDamageable(player);
+    }
+
+    bool running{true};
+    units::Frame waits_in_a_row{0};
+    FramePacer pacer(kFrameTime);
+    const auto start_time = FramePacer::Clock::now();
+    while (running) {
+        pacer.wait();
+        TRACE_ZONE("frame");
+        AllocationTracker::Scope frame_allocations(allocations_);
+        running = pollEvents(input);
+        connection.tick(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    FramePacer::Clock::now() - start_time));
+
+        // Checked before latching so that quitting works while waiting
+        if (input.isPressPending(BUTTON_PLUS)) {
             running = false;
         }
 
-        // Player Horizontal Movement
-        if (input.isKeyHeld(BUTTON_DPAD_LEFT)
-                && input.isKeyHeld(BUTTON_DPAD_RIGHT)) {
-            // if both left and right are being pressed we need to stop moving
-            player_->stopMoving();
-        } else if (input.isKeyHeld(BUTTON_DPAD_LEFT)) {
-            player_->startMovingLeft();
-        } else if (input.isKeyHeld(BUTTON_DPAD_RIGHT)) {
-            player_->startMovingRight();
+        rollBack(session);
+        if (session.shouldWait()) {
+            ++netplay_stats_.waits;
+            if (++waits_in_a_row > kMaxNetplayWaits) {
+                std::cout << "netplay: no input from the peer for "
+                    << kMaxNetplayWaits << " frames, ending the session\n";
+                running = false;
+            }
         } else {
-            player_->stopMoving();
+            waits_in_a_row = 0;
+            // Input is only latched for frames that use it, so edges
+            // pressed while waiting carry over
+            advance(session, input.latch());
         }
+        session.flush();
+        draw(graphics_);
+    }
+    netplay_stats_.report(std::cout);
+    allocations_.report(std::cout);
+}
+
+void Game::runNetplayScenario(const Scenario& scenario)
+{
+    NetplayConfig config;
+    config.seed = scenario.seed;
+    config.loopback = true;
+    config.latency = scenario.netplay_latency;
+    config.loss = scenario.netplay_loss;
+    NetplayConnection connection(config);
+    RollbackSession& session = connection.getSession();
 
-        if (input.isKeyHeld(BUTTON_DPAD_UP) &&
-                input.isKeyHeld(BUTTON_DPAD_DOWN)) {
-            player_->lookHorizontal();
-        } else if (input.isKeyHeld(BUTTON_DPAD_UP)) {
-            player_->lookUp();
-        } else if (input.isKeyHeld(BUTTON_DPAD_DOWN)) {
-            player_->lookDown();
+    addPlayer(Vector<units::Tile>{scenario.player.x + 1, scenario.player.y});
+    damage_texts_.addDamageable(players_[1]);
+
+    const InputFrame::Buttons fire_button =
+        scenario.sustained_fire ? InputFrame::Buttons{1} << BUTTON_B : 0;
+    units::Frame waits_in_a_row{0};
+    for (units::Frame tick = 0; session.getFrame() < scenario.num_frames;
+            ++tick) {
+        TRACE_ZONE("frame");
+        AllocationTracker::Scope frame_allocations(allocations_);
+        connection.tick(tick * kFrameTime);
+
+        rollBack(session);
+        if (session.shouldWait()) {
+            ++netplay_stats_.waits;
+            if (++waits_in_a_row > kMaxNetplayWaits) {
+                throw std::runtime_error("Netplay scenario lost its peer");
+            }
         } else {
-            player_->lookHorizontal();
+            waits_in_a_row = 0;
+            // Pulls the trigger every frame, like the offline scenario
+            advance(session, InputFrame{fire_button, fire_button, 0});
         }
+        session.flush();
+        SystemTimings::Scope scope(timings_, SystemTimings::DRAW);
+        draw(graphics_);
+    }
+}
 
-        // Player Jump
-        if (input.wasKeyPressed(BUTTON_A)) {
-            player_->startJump();
-        } else if (input.wasKeyReleased(BUTTON_A)) {
-            player_->stopJump();
-        }
-        // Player Fire
-        if (input.wasKeyPressed(BUTTON_B)) {
-            player_->startFire();
-        } else if (input.wasKeyReleased(BUTTON_B)) {
-            player_->stopFire();
+void Game::rollBack(RollbackSession& session)
+{
+    session.poll();
+    const units::Frame first = session.getRollbackFrame();
+    const units::Frame end = session.getFrame();
+    if (first == end) {
+        return;
+    }
+
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    restoreState(rollback_states_[first % rollback_states_.size()]);
+    for (units::Frame frame = first; frame < end; ++frame) {
+        if (frame != first) {
+            saveState(rollback_states_[frame % rollback_states_.size()]);
         }
+        simulateFrame(session, frame);
+    }
+    netplay_stats_.addRollback(end - first,
+            std::chrono::high_resolution_clock::now() - start_time);
+}
 
-        // update scene and last_updated_time
-        const auto current_time = high_resolution_clock::now();
-        const auto upd_elapsed_time = current_time - last_updated_time;
+void Game::advance(RollbackSession& session, const InputFrame& local_input)
+{
+    // The state of every frame the peer's inputs can still change
+    rollback_states_.resize(RollbackSession::kMaxRollback + 1);
 
-        update(
-                    std::chrono::milliseconds{ 1000 / 60},
-               graphics_
-              );
-        last_updated_time = current_time;
+    session.addLocalInput(local_input);
+    const units::Frame frame = session.getFrame();
+    saveState(rollback_states_[frame % rollback_states_.size()]);
+    simulateFrame(session, frame);
+    ++netplay_stats_.frames;
+}
 
-        draw(graphics_);
+void Game::simulateFrame(RollbackSession& session, units::Frame frame)
+{
+    for (std::size_t i = 0; i < players_.size(); ++i) {
+        applyInput(*players_[i], session.getInput(i, frame));
+    }
+    update(kFrameTime, graphics_);
+    session.simulated(frame);
+}
 
-        // calculate delay for constant fps
-        const auto end_time = high_resolution_clock::now();
-        const auto elapsed_time = duration_cast<milliseconds>(
-                end_time - start_time);
+void Game::applyInput(Player& player, const InputFrame& input)
+{
+    // Player Horizontal Movement
+    if (input.isHeld(BUTTON_DPAD_LEFT) && input.isHeld(BUTTON_DPAD_RIGHT)) {
+        // if both left and right are being pressed we need to stop moving
+        player.stopMoving();
+    } else if (input.isHeld(BUTTON_DPAD_LEFT)) {
+        player.startMovingLeft();
+    } else if (input.isHeld(BUTTON_DPAD_RIGHT)) {
+        player.startMovingRight();
+    } else {
+        player.stopMoving();
+    }
+
+    if (input.isHeld(BUTTON_DPAD_UP) && input.isHeld(BUTTON_DPAD_DOWN)) {
+        player.lookHorizontal();
+    } else if (input.isHeld(BUTTON_DPAD_UP)) {
+        player.lookUp();
+    } else if (input.isHeld(BUTTON_DPAD_DOWN)) {
+        player.lookDown();
+    } else {
+        player.lookHorizontal();
+    }
 
-        const auto delay_duration = milliseconds(1000) / kFps - elapsed_time;
-        if (delay_duration.count() >= 0)
-            SDL_Delay(delay_duration.count());
+    // Player Jump
+    if (input.wasPressed(BUTTON_A)) {
+        player.startJump();
+    } else if (input.wasReleased(BUTTON_A)) {
+        player.stopJump();
+    }
+    // Player Fire
+    if (input.wasPressed(BUTTON_B)) {
+        player.startFire();
+    } else if (input.wasReleased(BUTTON_B)) {
+        player.stopFire();
     }
 }
 
-void Game::update(const std::chrono::milliseconds elapsed_time, Graphics& graphics)
+void Game::runScenario(const Scenario& scenario)
+{
+    if (!scenario.map_file.empty()) {
+        map_ = Map::load(graphics_, scenario.map_file);
+    } else if (scenario.map_rows > 0 || scenario.map_cols > 0) {
+        map_ = Map::createCaveMap(graphics_,
+                scenario.map_rows, scenario.map_cols, scenario.seed);
+    }
+
+    Rng& spawns = random_.get(RandomStreams::Stream::SPAWNS);
+    const units::Game map_width = units::tileToGame(map_->getNumCols());
+    const units::Game map_height = units::tileToGame(map_->getNumRows());
+    for (const auto& bat : scenario.bats) {
+        FirstCaveBat::spawn(enemies_, Vector<units::Game>{
+                units::tileToGame(bat.x), units::tileToGame(bat.y)});
+    }
+    for (std::size_t i = 0; i < scenario.num_scattered_bats; ++i) {
+        FirstCaveBat::spawn(enemies_, Vector<units::Game>{
+                spawns.uniform(0.0, map_width),
+                spawns.uniform(0.0, map_height)});
+    }
+    damage_texts_.addDamageable(players_[0]);
+
+    SaveState snapshot;
+    if (scenario.netplay) {
+        runNetplayScenario(scenario);
+    } else {
+        runOfflineScenario(scenario, snapshot);
+    }
+
+    std::cout << "scenario: " << scenario.num_frames << " frames, "
+        << map_->getNumRows() << " x " << map_->getNumCols() << " tiles, "
+        << enemies_.size() << " enemies and "
+        << particle_system_.size() << " particles left, "
+        << jobs_.getNumThreads() << " threads\n";
+    timings_.report(scenario.num_frames);
+    if (!scenario.netplay && scenario.savestates_per_frame > 0) {
+        const double round_trips = static_cast<double>(scenario.num_frames) *
+            scenario.savestates_per_frame;
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+            << "savestates: " << snapshot.bytes.size()
+            << " bytes at the end, "
+            << timings_.getTotal(SystemTimings::SAVESTATES).count() * 1000.0 /
+                round_trips
+            << " us per save and restore\n";
+        std::cout << line.str();
+    }
+    if (scenario.netplay) {
+        netplay_stats_.report(std::cout);
+    } else {
+        // The same scenario ends on the same hash in every build that
+        // simulates the same way, which makes refactors easy to check. It
+        // is formatted apart so that the zero fill stays off std::cout.
+        std::ostringstream hash;
+        hash << std::hex << std::setfill('0') << std::setw(16)
+            << getStateHash();
+        std::cout << "state hash: " << hash.str() << "\n";
+    }
+    allocations_.report(std::cout);
+}
+
+void Game::runOfflineScenario(const Scenario& scenario, SaveState& snapshot)
 {
-    Timer::updateAll(elapsed_time);
-    damage_texts_.update(elapsed_time);
-    particle_system_.update(elapsed_time);
+    Rng& spawns = random_.get(RandomStreams::Stream::SPAWNS);
+    const units::Game map_width = units::tileToGame(map_->getNumCols());
+    const units::Game map_height = units::tileToGame(map_->getNumRows());
+    double particles_due = 0.0;
+    SaveState check;
+    for (units::Frame frame = 0; frame < scenario.num_frames; ++frame) {
+        TRACE_ZONE("frame");
+        AllocationTracker::Scope frame_allocations(allocations_);
+        if (scenario.sustained_fire) {
+            players_[0]->startFire();
+        }
+        {
+            SystemTimings::Scope scope(timings_, SystemTimings::PARTICLES);
+            particles_due += scenario.particles_per_second *
+                kFrameTime.count() / 1000.0;
+            for (; particles_due >= 1.0; particles_due -= 1.0) {
+                particle_system_.addHeadBumpParticle(Vector<units::Game>{
+                        spawns.uniform(0.0, map_width),
+                        spawns.uniform(0.0, map_height)},
+                        random_.get(RandomStreams::Stream::PARTICLES));
+            }
+        }
 
-    auto particle_tools = ParticleTools{ particle_system_, graphics };
-    //TODO: update map when it is changed
-    player_->update(elapsed_time, *map_, particle_tools);
-    auto player_pos = player_->getCenterPos();
-    if (bat_) {
-        if (!bat_->update(elapsed_time, player_pos.x)) {
-            bat_.reset();
+        if (scenario.savestates_per_frame > 0) {
+            {
+                SystemTimings::Scope scope(timings_, SystemTimings::SAVESTATES);
+                for (std::size_t i = 0;
+                        i < scenario.savestates_per_frame; ++i) {
+                    saveState(snapshot);
+                    restoreState(snapshot);
+                }
+            }
+            saveState(check);
+            if (check.bytes != snapshot.bytes) {
+                throw std::runtime_error(
+                        "Restoring a savestate changed the world");
+            }
         }
+
+        update(kFrameTime, graphics_);
+        {
+            SystemTimings::Scope scope(timings_, SystemTimings::DRAW);
+            draw(graphics_);
+        }
+    }
+
+}
+
+void Game::update(const std::chrono::milliseconds elapsed_time, Graphics& graphics)
+{
+    TRACE_ZONE("Game::update");
+    {
+        SystemTimings::Scope scope(timings_, SystemTimings::TIMERS);
+        Timer::updateAll(elapsed_time);
+        damage_texts_.update(elapsed_time);
+    }
+    {
+        SystemTimings::Scope scope(timings_, SystemTimings::PARTICLES);
+        particle_system_.update(elapsed_time, jobs_);
     }
 
-    auto projectiles = player_->getProjectiles();
-    for (auto projectile: projectiles) {
-        auto projectile_rect = projectile->getCollisionRectangle();
-        if (bat_ && bat_->getCollisionRectangle().collidesWith(projectile_rect)) {
-            projectile->collideWithEnemy();
-            bat_->takeDamage(projectile->getContactDamage());
+    auto particle_tools = ParticleTools{ particle_system_, graphics,
+        random_.get(RandomStreams::Stream::PARTICLES) };
+    {
+        SystemTimings::Scope scope(timings_, SystemTimings::MAP);
+        map_->update(Rectangle(0, 0,
+                    units::tileToGame(kScreenWidth),
+                    units::tileToGame(kScreenHeight)));
+    }
+    {
+        SystemTimings::Scope scope(timings_, SystemTimings::PLAYER);
+        for (const auto& player : players_) {
+            player->update(elapsed_time, *map_, particle_tools);
         }
     }
+    {
+        SystemTimings::Scope scope(timings_, SystemTimings::ENEMIES);
+        // Bats only turn towards the first player
+        auto player_pos = players_[0]->getCenterPos();
+        enemies_.update(elapsed_time, player_pos.x, jobs_);
+    }
+
+    SystemTimings::Scope scope(timings_, SystemTimings::COLLISIONS);
+    enemy_grid_.rebuild(enemies_.size(), [this](EnemyStore::Index i) {
+        return enemies_.getCollisionRectangle(i);
+    });
 
-    if (bat_) {
-        const auto batRect = bat_->getDamageRectangle();
-        if (batRect.collidesWith(player_->getDamageRectangle())) {
-            player_->takeDamage(bat_->contactDamage());
+    for (const auto& player : players_) {
+        for (auto& projectile : player->getProjectiles()) {
+            const auto projectile_rect = projectile.getCollisionRectangle();
+            // A projectile hits the first live enemy it touches
+            EnemyStore::Index target = enemies_.size();
+            enemy_grid_.query(projectile_rect, [&](EnemyStore::Index i) {
+                if (i < target && enemies_.isAlive(i) &&
+                        enemies_.getCollisionRectangle(i)
+                            .collidesWith(projectile_rect)) {
+                    target = i;
+                }
+            });
+            if (target != enemies_.size()) {
+                const auto damage = projectile.getContactDamage();
+                projectile.collideWithEnemy();
+                enemies_.takeDamage(target, damage);
+                damage_texts_.addDamage(enemies_.getCenterPos(target), damage);
+            }
         }
+
+        // Damage rectangles lie within collision rectangles, so the grid
+        // covers them
+        const auto player_rect = player->getDamageRectangle();
+        enemy_grid_.query(player_rect, [&](EnemyStore::Index i) {
+            if (enemies_.isAlive(i) &&
+                    enemies_.getDamageRectangle(i).collidesWith(player_rect)) {
+                player->takeDamage(enemies_.getContactDamage(i));
+            }
+        });
+    }
+}
+
+void Game::saveState(SaveState& state) const
+{
+    StateWriter writer(state);
+    Timer::saveClock(writer);
+    random_.save(writer);
+    for (const auto& player : players_) {
+        player->save(writer);
     }
+    enemies_.save(writer);
+    particle_system_.save(writer);
+    damage_texts_.save(writer);
+}
+
+void Game::restoreState(const SaveState& state)
+{
+    StateReader reader(state);
+    Timer::restoreClock(reader);
+    random_.restore(reader);
+    for (const auto& player : players_) {
+        player->restore(reader);
+    }
+    enemies_.restore(reader);
+    particle_system_.restore(reader);
+    damage_texts_.restore(reader);
+    reader.finish();
 }
 
 void Game::draw(Graphics& graphics) const
 {
+    TRACE_ZONE("Game::draw");
     graphics.clear();
 
     map_->drawBackground(graphics);
-    if (bat_)
-        bat_->draw(graphics);
-    player_->draw(graphics);
+    first_cave_bat_.draw(graphics, enemies_);
+    for (const auto& player : players_) {
+        player->draw(graphics);
+    }
     map_->draw(graphics);
     particle_system_.draw(graphics);
 
     damage_texts_.draw(graphics);
-    player_->drawHUD(graphics);
+    players_[local_player_]->drawHUD(graphics);
 
     graphics.flip();
 }
@@ -2,36 +2,136 @@
 #define GAME_H
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
+#include "allocation_tracker.h"
+#include "broadphase.h"
 #include "damage_texts.h"
+#include "enemy_store.h"
+#include "first_cave_bat.h"
+#include "frame_capture.h"
 #include "graphics.h"
+#include "job_system.h"
+#include "netplay.h"
 #include "particle_system.h"
+#include "replay.h"
+#include "rng.h"
+#include "savestate.h"
+#include "scenario.h"
 #include "sdlengine.h"
 #include "units.h"
+#include "vector.h"
 
+struct InputFrame;
 struct Map;
 struct Player;
-struct FirstCaveBat;
 
 struct Game {
+    // Plays in a window until the player quits
     Game();
+    // Runs |scenario| offscreen and prints per-system timings
+    explicit Game(const Scenario& scenario);
+    // Plays a two-player rollback session in a window until the local
+    // player quits
+    explicit Game(const NetplayConfig& config);
+    // Plays like Game(), or lets an InputBot play offscreen, and saves the
+    // session as a Replay
+    explicit Game(const RecordConfig& config);
+    // Replays segments of |replay| offscreen against its frame hashes and
+    // keyframes, then times seeking to random frames. Throws
+    // std::runtime_error if a segment diverges from the recording.
+    Game(const Replay& replay, const SeekBenchmark& benchmark);
+    // Plays like Game() and writes every frame shown; frames are dropped
+    // rather than slowing play if the encoder falls behind
+    explicit Game(const CaptureConfig& config);
+    // Replays frames of |replay| offscreen and writes every one of them.
+    // Throws std::runtime_error if the replay diverges from its hashes.
+    Game(const Replay& replay, const CaptureConfig& config);
     ~Game();
 
     static units::Tile kScreenWidth;
     static units::Tile kScreenHeight;
 
 private:
-    void runEventLoop();
+    // Everything random in the world is drawn from streams of |seed|
+    Game(Graphics::Output output, Uint32 sdl_subsystems,
+            Vector<units::Tile> player_tile, uint64_t seed);
+
+    // Adds the second player of a netplay session
+    void addPlayer(Vector<units::Tile> tile);
+    // The bat the windowed game starts with
+    void spawnTestBat();
+
+    // Records every frame into |replay| unless it is null
+    void runEventLoop(Replay* replay);
+    void runBotRecording(const RecordConfig& config, Replay& replay);
+    void runSeekBenchmark(const Replay& replay,
+            const SeekBenchmark& benchmark);
+    // Puts the world where |replay| was before |frame|
+    void seek(const Replay& replay, units::Frame frame);
+    void replayFrame(const Replay& replay, units::Frame frame);
+    void runReplayCapture(const Replay& replay, const CaptureConfig& config);
+    // Sends what graphics_ presents to |file_path| until finishCapture()
+    void startCapture(const std::string& file_path, bool drop_when_full);
+    void finishCapture();
+    void runScenario(const Scenario& scenario);
+    // Plays |scenario| alone; |snapshot| ends up holding the last savestate
+    // taken, if the scenario takes any
+    void runOfflineScenario(const Scenario& scenario, SaveState& snapshot);
+    void runNetplayLoop(const NetplayConfig& config);
+    // Plays |scenario| as player 0 against a LoopbackPeer, on a network
+    // simulated at the game's frame rate
+    void runNetplayScenario(const Scenario& scenario);
+    // Turns one frame of controller state into player actions
+    void applyInput(Player& player, const InputFrame& input);
+
+    // Takes the peer's inputs and, if they were mispredicted, restores the
+    // world and simulates up to the session's frame again
+    void rollBack(RollbackSession& session);
+    // Simulates the session's next frame with |local_input|; only call it
+    // when the session does not have to wait
+    void advance(RollbackSession& session, const InputFrame& local_input);
+    void simulateFrame(RollbackSession& session, units::Frame frame);
     void update(const std::chrono::milliseconds elapsed_time, Graphics& graphics);
     void draw(Graphics& graphics) const;
 
+    // Snapshot of everything update() changes: the world clock, random
+    // streams, player, enemies, particles and damage texts. The map and
+    // sprites are not included; they stay the same through a session.
+    void saveState(SaveState& state) const;
+    // Throws std::runtime_error if |state| does not fit this world
+    void restoreState(const SaveState& state);
+    // hashState() of the world as it is now
+    uint64_t getStateHash();
+
     const SDLEngine sdlEngine_;
     Graphics graphics_;
-    std::shared_ptr<Player> player_;
-    std::shared_ptr<FirstCaveBat> bat_;
+    JobSystem jobs_;
+    RandomStreams random_;
+    // One player, or two in netplay
+    std::vector<std::shared_ptr<Player> > players_;
+    // Player whose health the HUD shows
+    std::size_t local_player_;
+    EnemyStore enemies_;
+    // Every enemy in enemies_ is a bat for now
+    FirstCaveBat first_cave_bat_;
+    // Rebuilt from enemies_ every update
+    Broadphase enemy_grid_;
     std::unique_ptr<Map> map_;
     ParticleSystem particle_system_;
     DamageTexts damage_texts_;
+    SystemTimings timings_;
+    // Heap use of the frames of every loop
+    AllocationTracker allocations_;
+
+    // World at the start of each of the last frames, to roll back to
+    std::vector<SaveState> rollback_states_;
+    NetplayStats netplay_stats_;
+    // Reused by getStateHash()
+    SaveState hash_state_;
+    std::unique_ptr<FrameCapture> frame_capture_;
 };
 
 #endif /* GAME_H */
@@ -2,24 +2,55 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include "graphics.h"
+#include "frame_capture.h"
 #include "game.h"
+#include "text_renderer.h"
+#include "trace.h"
 
-Graphics::Graphics() :
-    sdlWindow {SDL_CreateWindow(
+namespace {
+
+const int kWindowWidth{1280};
+const int kWindowHeight{720};
+
+} // anonymous namespace
+
+Graphics::Graphics(Output output) :
+    sdlWindow {(output == Output::WINDOW)
+        ? SDL_CreateWindow(
                 "Cave Reconstructed",
                 0, 0,
-                1280,
-                720,
+                kWindowWidth,
+                kWindowHeight,
                 SDL_WINDOW_FULLSCREEN
-                )},
-    sdlRenderer {SDL_CreateRenderer(
-            sdlWindow,
-            -1,
-            SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE)},
-    sprite_sheets_()
+                )
+        : nullptr},
+    sdlSurface {(output == Output::OFFSCREEN)
+        ? SDL_CreateRGBSurfaceWithFormat(
+                0,
+                kWindowWidth,
+                kWindowHeight,
+                32,
+                SDL_PIXELFORMAT_ARGB8888)
+        : nullptr},
+    sdlRenderer {nullptr},
+    sprite_sheets_(),
+    sprite_registry_(*this),
+    text_renderer_(),
+    frame_capture_{nullptr}
 {
-    if (sdlWindow == nullptr) {
-        throw std::runtime_error("SDL_CreateWindow");
+    if (output == Output::WINDOW) {
+        if (sdlWindow == nullptr) {
+            throw std::runtime_error("SDL_CreateWindow");
+        }
+        sdlRenderer = SDL_CreateRenderer(
+                sdlWindow,
+                -1,
+                SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    } else {
+        if (sdlSurface == nullptr) {
+            throw std::runtime_error("SDL_CreateRGBSurfaceWithFormat");
+        }
+        sdlRenderer = SDL_CreateSoftwareRenderer(sdlSurface);
     }
     if (sdlRenderer == nullptr) {
         throw std::runtime_error("SDL_CreateRenderer");
@@ -34,7 +65,12 @@ Graphics::~Graphics()
         SDL_DestroyTexture(kv.second);
     }
     SDL_DestroyRenderer(sdlRenderer);
-    SDL_DestroyWindow(sdlWindow);
+    if (sdlWindow != nullptr) {
+        SDL_DestroyWindow(sdlWindow);
+    }
+    if (sdlSurface != nullptr) {
+        SDL_FreeSurface(sdlSurface);
+    }
 }
 
 /**
@@ -44,6 +80,7 @@ Graphics::~Graphics()
 SDL_Texture* Graphics::loadImage(const std::string& file_name,
         const bool black_is_transparent)
 {
+    TRACE_ZONE("Graphics::loadImage");
     const std::string file_path{
         (config::getGraphicsQuality() == config::GraphicsQuality::ORIGINAL)
             ? "content/original_graphics/" + file_name + ".pbm"
@@ -105,6 +142,23 @@ void Graphics::renderTexture(
 
 void Graphics::flip() const
 {
+    TRACE_ZONE("Graphics::flip");
+    if (frame_capture_ != nullptr) {
+        // The back buffer is undefined once presented
+        unsigned char* pixels = frame_capture_->beginFrame();
+        if (pixels != nullptr) {
+            // Reads the whole output; only the letterboxed viewport is
+            // written, at its place in the frame
+            const SDL_Rect output{0, 0, frame_capture_->getWidth(),
+                frame_capture_->getHeight()};
+            if (SDL_RenderReadPixels(sdlRenderer, &output,
+                        SDL_PIXELFORMAT_ARGB8888, pixels,
+                        frame_capture_->getPitch()) != 0) {
+                throw std::runtime_error("SDL_RenderReadPixels");
+            }
+            frame_capture_->endFrame();
+        }
+    }
     SDL_RenderPresent(sdlRenderer);
 }
 
@@ -112,3 +166,35 @@ void Graphics::clear() const
 {
     SDL_RenderClear(sdlRenderer);
 }
+
+int Graphics::getOutputWidth() const
+{
+    int width{0};
+    SDL_GetRendererOutputSize(sdlRenderer, &width, nullptr);
+    return width;
+}
+
+int Graphics::getOutputHeight() const
+{
+    int height{0};
+    SDL_GetRendererOutputSize(sdlRenderer, nullptr, &height);
+    return height;
+}
+
+void Graphics::setFrameCapture(FrameCapture* capture)
+{
+    frame_capture_ = capture;
+}
+
+SpriteRegistry& Graphics::getSpriteRegistry()
+{
+    return sprite_registry_;
+}
+
+TextRenderer& Graphics::getTextRenderer()
+{
+    if (!text_renderer_) {
+        text_renderer_ = std::make_unique<TextRenderer>(*this);
+    }
+    return *text_renderer_;
+}
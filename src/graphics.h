@@ -3,11 +3,22 @@
 
 #include <SDL2/SDL.h>
 #include <map>
+#include <memory>
 #include <string>
+#include "sprite_registry.h"
+
+struct FrameCapture;
+struct TextRenderer;
 
 struct Graphics
 {
-    Graphics();
+    enum class Output {
+        WINDOW,
+        // Renders into a surface in memory; nothing is shown
+        OFFSCREEN
+    };
+
+    explicit Graphics(Output output=Output::WINDOW);
     ~Graphics();
 
     Graphics(const Graphics&)=delete;
@@ -26,10 +37,25 @@ struct Graphics
     void flip() const;
     void clear() const;
 
+    // Size in pixels of what flip() presents
+    int getOutputWidth() const;
+    int getOutputHeight() const;
+    // Hands every frame flip() presents to |capture| until it is set to
+    // nullptr. Frames are read at the output size.
+    void setFrameCapture(FrameCapture* capture);
+
+    SpriteRegistry& getSpriteRegistry();
+    // Built on first use, once the renderer can load the font sheets
+    TextRenderer& getTextRenderer();
+
 private:
     SDL_Window *sdlWindow;
+    SDL_Surface *sdlSurface;
     SDL_Renderer *sdlRenderer;
     std::map<std::string, SDL_Texture*> sprite_sheets_;
+    SpriteRegistry sprite_registry_;
+    std::unique_ptr<TextRenderer> text_renderer_;
+    FrameCapture* frame_capture_;
 };
 
 #endif /*  GRAPHICS_H  */
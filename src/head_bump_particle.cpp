@@ -1,7 +1,9 @@
+#include <algorithm>
 #include "head_bump_particle.h"
-#include "rand.h"
-#include <iostream>
-#include <utility>
+#include "graphics.h"
+#include "job_system.h"
+#include "rng.h"
+#include "savestate.h"
 
 const units::Game kSourceX{116};
 const units::Game kSourceY{54};
@@ -10,42 +12,161 @@ const units::Game kSourceHeight{6};
 
 const std::chrono::milliseconds kLifeTime{600};
 const std::chrono::milliseconds kFlashPeriod{25};
-const bool kTimerStartActive{true};
 const units::Velocity kSpeed{0.12};
 
-HeadBumpParticle::HeadBumpParticle(Graphics& graphics,
-        Vector<units::Game> center_pos) :
-    sprite_(graphics, "Caret",
+// Particles per job
+const std::size_t kUpdateGrain{4096};
+// Room for the bumps of normal play, so that spawning does not allocate
+const std::size_t kReservedParticles{1024};
+
+namespace {
+
+// Moves the last element into |index| and shrinks the array
+template <typename T>
+void removeSwapped(std::vector<T>& components, std::size_t index)
+{
+    components[index] = components.back();
+    components.pop_back();
+}
+
+} // anonymous namespace
+
+HeadBumpParticlePool::HeadBumpParticlePool(Graphics& graphics) :
+    sprite_{graphics.getSpriteRegistry().add("Caret",
             units::gameToPixel(kSourceX),
             units::gameToPixel(kSourceY),
             units::gameToPixel(kSourceWidth),
-            units::gameToPixel(kSourceHeight)),
-    live_timer_(kLifeTime, kTimerStartActive),
-    center_pos_(std::move(center_pos)),
-    particle_a_(0, rand_angle()),
-    particle_b_(0, rand_angle()),
-    game_max_offset_a_{static_cast<units::Game>(rand_double(4.0, 20.0))},
-    game_max_offset_b_{static_cast<units::Game>(rand_double(4.0, 20.0))}
-{}
-
-void HeadBumpParticle::draw(Graphics& graphics) const
-{
-    if (live_timer_.current_time() / kFlashPeriod % 2 == 0) {
-        sprite_.draw(graphics, center_pos_ + particle_a_.getPos());
-        sprite_.draw(graphics, center_pos_ + particle_b_.getPos());
+            units::gameToPixel(kSourceHeight))},
+    center_x_(),
+    center_y_(),
+    direction_a_x_(),
+    direction_a_y_(),
+    direction_b_x_(),
+    direction_b_y_(),
+    offset_a_(),
+    offset_b_(),
+    max_offset_a_(),
+    max_offset_b_(),
+    age_()
+{
+    for (auto* components : {&center_x_, &center_y_,
+            &direction_a_x_, &direction_a_y_, &direction_b_x_, &direction_b_y_,
+            &offset_a_, &offset_b_, &max_offset_a_, &max_offset_b_, &age_}) {
+        components->reserve(kReservedParticles);
+    }
+}
+
+HeadBumpParticlePool::~HeadBumpParticlePool() {}
+
+void HeadBumpParticlePool::spawn(Vector<units::Game> center_pos, Rng& random)
+{
+    const units::Degrees angle_a = random.angle();
+    const units::Degrees angle_b = random.angle();
+    center_x_.push_back(center_pos.x);
+    center_y_.push_back(center_pos.y);
+    direction_a_x_.push_back(units::cos(angle_a));
+    direction_a_y_.push_back(units::sin(angle_a));
+    direction_b_x_.push_back(units::cos(angle_b));
+    direction_b_y_.push_back(units::sin(angle_b));
+    offset_a_.push_back(0.0);
+    offset_b_.push_back(0.0);
+    max_offset_a_.push_back(random.uniform(4.0, 20.0));
+    max_offset_b_.push_back(random.uniform(4.0, 20.0));
+    age_.push_back(0.0);
+}
+
+std::size_t HeadBumpParticlePool::size() const
+{
+    return center_x_.size();
+}
+
+void HeadBumpParticlePool::update(const std::chrono::milliseconds elapsed_time,
+        JobSystem& jobs)
+{
+    const double dt = elapsed_time.count();
+    jobs.parallelFor(size(), kUpdateGrain,
+            [this, dt](std::size_t begin, std::size_t end) {
+                updateRange(dt, begin, end);
+            });
+    removeDead();
+}
+
+void HeadBumpParticlePool::draw(Graphics& graphics) const
+{
+    const auto flash_period = static_cast<double>(kFlashPeriod.count());
+    const SpriteRegistry& sprites = graphics.getSpriteRegistry();
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (static_cast<long>(age_[i] / flash_period) % 2 != 0) {
+            continue;
+        }
+        sprites.draw(sprite_, Vector<units::Game>{
+                center_x_[i] + direction_a_x_[i] * offset_a_[i],
+                center_y_[i] + direction_a_y_[i] * offset_a_[i]});
+        sprites.draw(sprite_, Vector<units::Game>{
+                center_x_[i] + direction_b_x_[i] * offset_b_[i],
+                center_y_[i] + direction_b_y_[i] * offset_b_[i]});
     }
 }
 
-bool HeadBumpParticle::update(const std::chrono::milliseconds elapsed_time)
+void HeadBumpParticlePool::save(StateWriter& writer) const
 {
-    const auto magn_diff = kSpeed * elapsed_time.count();
-    particle_a_.setMagnitude(std::min(
-                particle_a_.getMagnitude() + magn_diff,
-                game_max_offset_a_));
+    writer.writeArray(center_x_);
+    writer.writeArray(center_y_);
+    writer.writeArray(direction_a_x_);
+    writer.writeArray(direction_a_y_);
+    writer.writeArray(direction_b_x_);
+    writer.writeArray(direction_b_y_);
+    writer.writeArray(offset_a_);
+    writer.writeArray(offset_b_);
+    writer.writeArray(max_offset_a_);
+    writer.writeArray(max_offset_b_);
+    writer.writeArray(age_);
+}
 
-    particle_b_.setMagnitude(std::min(
-                particle_b_.getMagnitude() + magn_diff,
-                game_max_offset_b_));
+void HeadBumpParticlePool::restore(StateReader& reader)
+{
+    reader.readArray(center_x_);
+    reader.readArray(center_y_);
+    reader.readArray(direction_a_x_);
+    reader.readArray(direction_a_y_);
+    reader.readArray(direction_b_x_);
+    reader.readArray(direction_b_y_);
+    reader.readArray(offset_a_);
+    reader.readArray(offset_b_);
+    reader.readArray(max_offset_a_);
+    reader.readArray(max_offset_b_);
+    reader.readArray(age_);
+}
 
-    return live_timer_.is_active();
+void HeadBumpParticlePool::updateRange(double dt,
+        std::size_t begin, std::size_t end)
+{
+    const units::Game step = kSpeed * dt;
+    for (std::size_t i = begin; i < end; ++i) {
+        offset_a_[i] = std::min(offset_a_[i] + step, max_offset_a_[i]);
+        offset_b_[i] = std::min(offset_b_[i] + step, max_offset_b_[i]);
+        age_[i] += dt;
+    }
+}
+
+void HeadBumpParticlePool::removeDead()
+{
+    const auto life_time = static_cast<double>(kLifeTime.count());
+    for (std::size_t i = 0; i < size(); ) {
+        if (age_[i] < life_time) {
+            ++i;
+            continue;
+        }
+        removeSwapped(center_x_, i);
+        removeSwapped(center_y_, i);
+        removeSwapped(direction_a_x_, i);
+        removeSwapped(direction_a_y_, i);
+        removeSwapped(direction_b_x_, i);
+        removeSwapped(direction_b_y_, i);
+        removeSwapped(offset_a_, i);
+        removeSwapped(offset_b_, i);
+        removeSwapped(max_offset_a_, i);
+        removeSwapped(max_offset_b_, i);
+        removeSwapped(age_, i);
+    }
 }
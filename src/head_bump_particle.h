@@ -2,28 +2,55 @@
 #define HEAD_BUMP_PARTICLE_H_
 
 #include <chrono>
-#include "particle.h"
-#include "polar_vector.h"
-#include "sprite.h"
-#include "timer.h"
+#include <cstddef>
+#include <vector>
+#include "sprite_registry.h"
 #include "units.h"
 #include "vector.h"
 
 struct Graphics;
+struct JobSystem;
+struct Rng;
+struct StateReader;
+struct StateWriter;
 
-struct HeadBumpParticle : public Particle {
-   HeadBumpParticle(Graphics& graphics, Vector<units::Game> center_pos);
+// Pool of the pairs of sparks that fly apart when the player bumps their
+// head. Particles are stored as structure-of-arrays and share one sprite;
+// dead ones are removed by moving the last particle into their slot.
+struct HeadBumpParticlePool {
+    HeadBumpParticlePool(Graphics& graphics);
+    ~HeadBumpParticlePool();
+
+    // Adds a pair of sparks heading in random directions from |center_pos|
+    void spawn(Vector<units::Game> center_pos, Rng& random);
+    std::size_t size() const;
+
+    void update(const std::chrono::milliseconds elapsed_time, JobSystem& jobs);
+    void draw(Graphics& graphics) const;
+
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
 
-   void draw(Graphics& graphics) const override;
-   bool update(const std::chrono::milliseconds elapsed_time) override;
 private:
-   Sprite sprite_;
-   Timer live_timer_;
-   const Vector<units::Game> center_pos_;
-   PolarVector particle_a_;
-   PolarVector particle_b_;
-   const units::Game game_max_offset_a_;
-   const units::Game game_max_offset_b_;
+    void updateRange(double dt, std::size_t begin, std::size_t end);
+    void removeDead();
+
+    const SpriteRegistry::Id sprite_;
+
+    std::vector<units::Game> center_x_;
+    std::vector<units::Game> center_y_;
+    // Unit direction of each spark, fixed at spawn
+    std::vector<units::Game> direction_a_x_;
+    std::vector<units::Game> direction_a_y_;
+    std::vector<units::Game> direction_b_x_;
+    std::vector<units::Game> direction_b_y_;
+    // Distance travelled, up to the max
+    std::vector<units::Game> offset_a_;
+    std::vector<units::Game> offset_b_;
+    std::vector<units::Game> max_offset_a_;
+    std::vector<units::Game> max_offset_b_;
+    // Milliseconds since spawn
+    std::vector<double> age_;
 };
 
 #endif /* HEAD_BUMP_PARTICLE_H_ */
@@ -1,40 +1,141 @@
 #include "input.h"
 
-Input::Input() :
-    held_keys_(),
-    pressed_keys_(),
-    released_keys_()
-{}
+namespace {
+
+// Buttons an InputBot plays with, and how often it changes one
+const int kBotButtons[] = {
+    BUTTON_DPAD_LEFT, BUTTON_DPAD_RIGHT, BUTTON_A, BUTTON_B
+};
+const uint32_t kBotChangeOdds{12};
 
-void Input::beginNewFrame()
+} // anonymous namespace
+
+bool InputFrame::isHeld(int button) const
 {
-    pressed_keys_.clear();
-    released_keys_.clear();
+    return button >= 0 && button < static_cast<int>(kNumButtons)
+        && (held >> button & 1) != 0;
 }
 
+bool InputFrame::wasPressed(int button) const
+{
+    return button >= 0 && button < static_cast<int>(kNumButtons)
+        && (pressed >> button & 1) != 0;
+}
+
+bool InputFrame::wasReleased(int button) const
+{
+    return button >= 0 && button < static_cast<int>(kNumButtons)
+        && (released >> button & 1) != 0;
+}
+
+bool operator==(const InputFrame& a, const InputFrame& b)
+{
+    return a.held == b.held
+        && a.pressed == b.pressed
+        && a.released == b.released;
+}
+
+bool operator!=(const InputFrame& a, const InputFrame& b)
+{
+    return !(a == b);
+}
+
+Input::Input() :
+    held_{0},
+    previous_held_{0},
+    down_events_{0},
+    up_events_{0},
+    event_times_(),
+    pending_first_event_time_{0},
+    first_event_time_{0}
+{}
+
 void Input::keyDownEvent(const SDL_Event& event)
 {
-    pressed_keys_[event.jbutton.button] = true;
-    held_keys_[event.jbutton.button] = true;
+    const InputFrame::Buttons button = bit(event.jbutton.button);
+    held_ |= button;
+    down_events_ |= button;
+    recordEventTime(event.jbutton.button, event.jbutton.timestamp);
 }
 
 void Input::keyUpEvent(const SDL_Event& event)
 {
-    released_keys_[event.jbutton.button] = true;
-    held_keys_[event.jbutton.button] = false;
+    const InputFrame::Buttons button = bit(event.jbutton.button);
+    held_ &= ~button;
+    up_events_ |= button;
+    recordEventTime(event.jbutton.button, event.jbutton.timestamp);
+}
+
+InputFrame Input::latch()
+{
+    const InputFrame::Buttons changed = held_ ^ previous_held_;
+    // Went down and up again (or up and down) between two latches
+    const InputFrame::Buttons bounced = down_events_ & up_events_ & ~changed;
+    const InputFrame frame{
+        held_,
+        (changed & held_) | bounced,
+        (changed & ~held_) | bounced
+    };
+
+    previous_held_ = held_;
+    down_events_ = 0;
+    up_events_ = 0;
+    first_event_time_ = pending_first_event_time_;
+    pending_first_event_time_ = 0;
+    return frame;
+}
+
+bool Input::isPressPending(int button) const
+{
+    return (down_events_ & bit(button)) != 0;
 }
 
-bool Input::wasKeyPressed(int key)
+Uint32 Input::getFirstEventTime() const
 {
-    return pressed_keys_[key];
+    return first_event_time_;
 }
 
-bool Input::wasKeyReleased(int key)
+Uint32 Input::getEventTime(int button) const
 {
-    return released_keys_[key];
+    if (bit(button) == 0) {
+        return 0;
+    }
+    return event_times_[button];
 }
 
-bool Input::isKeyHeld(int key)
+InputFrame::Buttons Input::bit(int button)
+{
+    if (button < 0 || button >= static_cast<int>(InputFrame::kNumButtons)) {
+        return 0;
+    }
+    return InputFrame::Buttons{1} << button;
+}
+
+void Input::recordEventTime(int button, Uint32 timestamp)
+{
+    if (bit(button) != 0) {
+        event_times_[button] = timestamp;
+    }
+    if (pending_first_event_time_ == 0 ||
+            timestamp < pending_first_event_time_) {
+        pending_first_event_time_ = timestamp;
+    }
+}
+
+InputBot::InputBot(Rng random) :
+    random_(random),
+    held_{0}
+{}
+
+InputFrame InputBot::next()
 {
-    return held_keys_[key];
+    const InputFrame::Buttons previous = held_;
+    if (random_.between(1, kBotChangeOdds) == 1) {
+        const std::size_t num_buttons =
+            sizeof(kBotButtons) / sizeof(kBotButtons[0]);
+        const int button = kBotButtons[random_.between(0, num_buttons - 1)];
+        held_ ^= InputFrame::Buttons{1} << button;
+    }
+    const InputFrame::Buttons changed = held_ ^ previous;
+    return InputFrame{held_, changed & held_, changed & ~held_};
 }
@@ -2,23 +2,92 @@
 #define INPUT_H
 
 #include <SDL2/SDL.h>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include "rng.h"
 
+// Joystick buttons of a Switch controller
+#define BUTTON_DPAD_UP 13
+#define BUTTON_DPAD_DOWN 15
+#define BUTTON_DPAD_LEFT 12
+#define BUTTON_DPAD_RIGHT 14
+#define BUTTON_PLUS 10
+#define BUTTON_A 0
+#define BUTTON_B 1
+#define BUTTON_X 2
+#define BUTTON_Y 3
+
+// Controller state for one simulation step: the buttons held, and those
+// that went down or up since the previous step, one bit per joystick
+// button. It is plain bits so steps can be hashed, recorded and compared
+// byte for byte.
+struct InputFrame {
+    typedef uint32_t Buttons;
+    static const std::size_t kNumButtons{32};
+
+    Buttons held;
+    Buttons pressed;
+    Buttons released;
+
+    bool isHeld(int button) const;
+    bool wasPressed(int button) const;
+    bool wasReleased(int button) const;
+};
+
+bool operator==(const InputFrame& a, const InputFrame& b);
+bool operator!=(const InputFrame& a, const InputFrame& b);
+
+// Collects joystick events as they arrive and turns them into InputFrames.
+// Edges come from XOR-ing the held buttons of consecutive frames; a button
+// that went down and back up between two frames counts as both pressed
+// and released.
 struct Input {
     Input();
 
-    void beginNewFrame();
-
     void keyDownEvent(const SDL_Event& event);
     void keyUpEvent(const SDL_Event& event);
 
-    bool wasKeyPressed(int key);
-    bool wasKeyReleased(int key);
-    bool isKeyHeld(int key);
+    // Builds the frame for the next simulation step out of the events seen
+    // since the previous call. Call it right before that step, after
+    // polling events, so input is sampled as late as possible.
+    InputFrame latch();
+    // Whether |button| went down since the last latch(), without latching,
+    // for loops that go on polling while they hold input back
+    bool isPressPending(int button) const;
+
+    // SDL timestamp of the earliest event folded into the last latched
+    // frame, or 0 if there was none
+    Uint32 getFirstEventTime() const;
+    // SDL timestamp of the latest event for |button|, or 0 if none yet
+    Uint32 getEventTime(int button) const;
+
+private:
+    // Bit for |button|, or 0 for buttons beyond kNumButtons
+    static InputFrame::Buttons bit(int button);
+    void recordEventTime(int button, Uint32 timestamp);
+
+    InputFrame::Buttons held_;
+    InputFrame::Buttons previous_held_;
+    // Buttons that had a down or up event since the last latch
+    InputFrame::Buttons down_events_;
+    InputFrame::Buttons up_events_;
+
+    Uint32 event_times_[InputFrame::kNumButtons];
+    Uint32 pending_first_event_time_;
+    Uint32 first_event_time_;
+};
+
+// Random button presses for players without a human: the d-pad, jump and
+// fire, one of them flipping now and then
+struct InputBot {
+    explicit InputBot(Rng random);
+
+    // Input for the next simulation step
+    InputFrame next();
+
 private:
-    std::map<int, bool> held_keys_;
-    std::map<int, bool> pressed_keys_;
-    std::map<int, bool> released_keys_;
+    Rng random_;
+    InputFrame::Buttons held_;
 };
 
 #endif /* INPUT_H */
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <string>
+#include "job_system.h"
+#include "trace.h"
+
+namespace {
+
+// Chunks dealt per thread, so that uneven chunks can be rebalanced
+const std::size_t kChunksPerThread{4};
+
+std::size_t getNumCores()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // anonymous namespace
+
+JobSystem::JobSystem() :
+    JobSystem(getNumCores())
+{}
+
+JobSystem::JobSystem(std::size_t num_threads) :
+    queues_(),
+    workers_(),
+    invoke_{nullptr},
+    body_{nullptr},
+    pending_{0},
+    wake_mutex_(),
+    wake_(),
+    generation_{0},
+    stopping_{false}
+{
+    num_threads = std::max<std::size_t>(num_threads, 1);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    // Queue 0 belongs to the thread calling parallelFor()
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        workers_.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+std::size_t JobSystem::getNumThreads() const
+{
+    return queues_.size();
+}
+
+void JobSystem::run(Invoke invoke, const void* body,
+        std::size_t count, std::size_t grain)
+{
+    const std::size_t num_queues = queues_.size();
+    const std::size_t chunk = std::max(grain,
+            (count + num_queues * kChunksPerThread - 1) /
+            (num_queues * kChunksPerThread));
+    const std::size_t num_chunks = (count + chunk - 1) / chunk;
+
+    invoke_ = invoke;
+    body_ = body;
+    pending_.store(num_chunks, std::memory_order_relaxed);
+    // Contiguous chunks per queue, so each thread walks its own stretch of
+    // memory until it runs dry and starts stealing
+    for (std::size_t q = 0; q < num_queues; ++q) {
+        const std::size_t first = num_chunks * q / num_queues;
+        const std::size_t last = num_chunks * (q + 1) / num_queues;
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        for (std::size_t c = first; c < last; ++c) {
+            queues_[q]->ranges.push_back(
+                    Range{c * chunk, std::min(count, (c + 1) * chunk)});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runRanges(0);
+    while (pending_.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(std::size_t queue)
+{
+    trace::setThreadName(("job worker " + std::to_string(queue)).c_str());
+    unsigned seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [&] {
+                return stopping_ || generation_ != seen_generation;
+            });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        runRanges(queue);
+    }
+}
+
+void JobSystem::runRanges(std::size_t queue)
+{
+    Range range;
+    while (popRange(queue, range)) {
+        TRACE_ZONE("JobSystem job");
+        invoke_(body_, range.begin, range.end);
+        pending_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+bool JobSystem::popRange(std::size_t queue, Range& range)
+{
+    {
+        Queue& own = *queues_[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t i = 1; i < queues_.size(); ++i) {
+        Queue& victim = *queues_[(queue + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,99 @@
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing scheduler for data-parallel loops. parallelFor() cuts
+// a range into chunks and deals them out to one deque per thread; each
+// thread pops chunks from the back of its own deque and, once that is
+// empty, steals from the front of the others'. The calling thread takes
+// part and returns only when every chunk is done.
+//
+// Bodies may run in any order on any thread, so they must only write state
+// owned by their own indices. Side effects that other entities see (damage,
+// spawns, removals) are recorded per index and applied by the caller
+// afterwards, in index order, which keeps the result identical to a serial
+// run.
+struct JobSystem {
+    // Uses one thread per core, the calling thread included
+    JobSystem();
+    explicit JobSystem(std::size_t num_threads);
+    JobSystem(const JobSystem&)=delete;
+    JobSystem& operator=(const JobSystem&)=delete;
+    ~JobSystem();
+
+    std::size_t getNumThreads() const;
+
+    // Calls body(begin, end) for disjoint ranges covering [0, count), each
+    // at least |grain| long save the last. Ranges run inline when there is
+    // only one of them. Not reentrant: bodies must not call parallelFor().
+    template <typename Body>
+    void parallelFor(std::size_t count, std::size_t grain, Body body);
+
+private:
+    typedef void (*Invoke)(const void* body,
+            std::size_t begin, std::size_t end);
+
+    struct Range {
+        std::size_t begin;
+        std::size_t end;
+    };
+    struct Queue {
+        Queue() :
+            mutex(),
+            ranges()
+        {}
+
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    template <typename Body>
+    static void invoke(const void* body, std::size_t begin, std::size_t end);
+
+    void run(Invoke invoke, const void* body,
+            std::size_t count, std::size_t grain);
+    void workerLoop(std::size_t queue);
+    void runRanges(std::size_t queue);
+    bool popRange(std::size_t queue, Range& range);
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> workers_;
+
+    // Current job, published to the workers through the queue mutexes
+    Invoke invoke_;
+    const void* body_;
+    std::atomic<std::size_t> pending_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    unsigned generation_;
+    bool stopping_;
+};
+
+template <typename Body>
+void JobSystem::invoke(const void* body, std::size_t begin, std::size_t end)
+{
+    (*static_cast<const Body*>(body))(begin, end);
+}
+
+template <typename Body>
+void JobSystem::parallelFor(std::size_t count, std::size_t grain, Body body)
+{
+    if (count <= grain || workers_.empty()) {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+    run(&invoke<Body>, &body, count, grain);
+}
+
+#endif /* JOB_SYSTEM_H_ */
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "latency_tracker.h"
+
+const std::size_t LatencyTracker::Histogram::kNumBuckets;
+
+LatencyTracker::LatencyTracker() :
+    pending_{false},
+    pending_event_time_{0},
+    to_update_(),
+    to_present_()
+{}
+
+void LatencyTracker::startUpdate(Uint32 first_event_time, Uint32 now)
+{
+    pending_ = (first_event_time != 0);
+    if (!pending_) {
+        return;
+    }
+    pending_event_time_ = first_event_time;
+    to_update_.add(now - std::min(now, first_event_time));
+}
+
+void LatencyTracker::presented(Uint32 now)
+{
+    if (!pending_) {
+        return;
+    }
+    pending_ = false;
+    to_present_.add(now - std::min(now, pending_event_time_));
+}
+
+std::size_t LatencyTracker::size() const
+{
+    return to_present_.size_;
+}
+
+void LatencyTracker::report(std::ostream& out) const
+{
+    out << "input latency: " << to_present_.size_ << " frames with input\n";
+    to_update_.report("to update", out);
+    to_present_.report("to present", out);
+}
+
+LatencyTracker::Histogram::Histogram() :
+    counts_(),
+    size_{0},
+    total_{0},
+    max_{0}
+{}
+
+void LatencyTracker::Histogram::add(Uint32 latency)
+{
+    ++counts_[std::min<std::size_t>(latency, kNumBuckets - 1)];
+    ++size_;
+    total_ += latency;
+    max_ = std::max(max_, latency);
+}
+
+Uint32 LatencyTracker::Histogram::getPercentile(double fraction) const
+{
+    const auto rank = static_cast<uint64_t>(fraction * size_);
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        seen += counts_[bucket];
+        if (seen > rank) {
+            return static_cast<Uint32>(bucket);
+        }
+    }
+    return max_;
+}
+
+void LatencyTracker::Histogram::report(const char* name,
+        std::ostream& out) const
+{
+    if (size_ == 0) {
+        return;
+    }
+    // Formatted apart so the precision does not stick to |out|
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1)
+        << "  " << std::setw(10) << name << ": "
+        << static_cast<double>(total_) / size_ << " ms average, "
+        << "p50 " << getPercentile(0.50) << " ms, "
+        << "p90 " << getPercentile(0.90) << " ms, "
+        << "p99 " << getPercentile(0.99) << " ms, "
+        << "max " << max_ << " ms\n";
+    out << line.str();
+}
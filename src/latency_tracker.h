@@ -0,0 +1,51 @@
+#ifndef LATENCY_TRACKER_H_
+#define LATENCY_TRACKER_H_
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Measures input latency over a play session. Each frame that consumed
+// input is followed from the SDL timestamp of its earliest event, to the
+// start of the update that consumed it, to the flip that presented the
+// result. Times are SDL ticks (milliseconds), the clock SDL stamps events
+// with. Samples go into fixed millisecond histograms, so a session of any
+// length costs the same memory.
+struct LatencyTracker {
+    LatencyTracker();
+
+    // An update is starting at |now| on input whose earliest event was at
+    // |first_event_time|; 0 means the update consumed no events.
+    void startUpdate(Uint32 first_event_time, Uint32 now);
+    // The frame drawn after the last update was presented at |now|
+    void presented(Uint32 now);
+
+    std::size_t size() const;
+    // Prints the distribution of both latencies
+    void report(std::ostream& out) const;
+
+private:
+    struct Histogram {
+        // One bucket per millisecond; the last also holds everything slower
+        static const std::size_t kNumBuckets{256};
+
+        Histogram();
+
+        void add(Uint32 latency);
+        Uint32 getPercentile(double fraction) const;
+        void report(const char* name, std::ostream& out) const;
+
+        uint64_t counts_[kNumBuckets];
+        uint64_t size_;
+        uint64_t total_;
+        Uint32 max_;
+    };
+
+    bool pending_;
+    Uint32 pending_event_time_;
+    Histogram to_update_;
+    Histogram to_present_;
+};
+
+#endif /* LATENCY_TRACKER_H_ */
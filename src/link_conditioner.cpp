@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <utility>
+#include "link_conditioner.h"
+
+// Datagrams held back at once before the queues grow
+const std::size_t kReservedDatagrams{64};
+
+LinkConditioner::LinkConditioner(DatagramLink& link,
+        std::chrono::milliseconds latency, std::chrono::milliseconds jitter,
+        double loss, uint64_t seed) :
+    link_(link),
+    latency_{latency},
+    jitter_{jitter},
+    loss_{loss},
+    random_(seed),
+    now_{0},
+    pending_(),
+    incoming_(),
+    spare_()
+{
+    pending_.reserve(kReservedDatagrams);
+    spare_.reserve(kReservedDatagrams);
+}
+
+void LinkConditioner::setNow(std::chrono::milliseconds now)
+{
+    now_ = now;
+}
+
+void LinkConditioner::send(const unsigned char* data, std::size_t size)
+{
+    link_.send(data, size);
+}
+
+bool LinkConditioner::receive(std::vector<unsigned char>& datagram)
+{
+    while (link_.receive(incoming_)) {
+        if (random_.uniform(0.0, 1.0) < loss_) {
+            continue;
+        }
+        const std::chrono::milliseconds delay{latency_.count() +
+            random_.between(0, static_cast<uint32_t>(jitter_.count()))};
+        pending_.push_back(Pending{now_ + delay, std::vector<unsigned char>()});
+        pending_.back().datagram.swap(incoming_);
+        if (!spare_.empty()) {
+            incoming_.swap(spare_.back());
+            spare_.pop_back();
+        }
+    }
+
+    const auto first = std::min_element(pending_.begin(), pending_.end(),
+            [](const Pending& a, const Pending& b) {
+                return a.arrival_time < b.arrival_time;
+            });
+    if (first == pending_.end() || first->arrival_time > now_) {
+        return false;
+    }
+    datagram.swap(first->datagram);
+    spare_.push_back(std::move(first->datagram));
+    pending_.erase(first);
+    return true;
+}
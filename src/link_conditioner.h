@@ -0,0 +1,43 @@
+#ifndef LINK_CONDITIONER_H_
+#define LINK_CONDITIONER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rng.h"
+#include "udp_link.h"
+
+// Makes a good link behave like a bad one, to try netplay on one machine:
+// wraps a DatagramLink and holds back what it receives for |latency| plus
+// up to |jitter|, dropping a |loss| fraction of it. Jitter can reorder
+// datagrams. Time only moves when the owner calls setNow(), so headless
+// runs can play against a simulated clock.
+struct LinkConditioner final : public DatagramLink {
+    LinkConditioner(DatagramLink& link, std::chrono::milliseconds latency,
+            std::chrono::milliseconds jitter, double loss, uint64_t seed);
+
+    void setNow(std::chrono::milliseconds now);
+
+    void send(const unsigned char* data, std::size_t size) override;
+    bool receive(std::vector<unsigned char>& datagram) override;
+
+private:
+    struct Pending {
+        std::chrono::milliseconds arrival_time;
+        std::vector<unsigned char> datagram;
+    };
+
+    DatagramLink& link_;
+    const std::chrono::milliseconds latency_;
+    const std::chrono::milliseconds jitter_;
+    const double loss_;
+    Rng random_;
+    std::chrono::milliseconds now_;
+    std::vector<Pending> pending_;
+    std::vector<unsigned char> incoming_;
+    // Buffers handed back by receive(), so that held datagrams reuse them
+    std::vector<std::vector<unsigned char> > spare_;
+};
+
+#endif /* LINK_CONDITIONER_H_ */
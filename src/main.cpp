@@ -1,10 +1,303 @@
+#include "allocation_tracker.h"
+#include "benchmark.h"
 #include "game.h"
+#include "graphics.h"
+#include "map.h"
+#include "sdlengine.h"
+#include "trace.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main()
+const units::Frame kBenchmarkFrames{600};
+const std::size_t kNumAllocationSites{20};
+const uint64_t kMaxFrames{std::numeric_limits<units::Frame>::max()};
+// Limits of netplay options, in frames and milliseconds
+const units::Frame kMaxInputDelay{60};
+const uint64_t kMaxLatency{10000};
+
+namespace {
+
+const char kUsage[] =
+    "usage: cave [--trace <file>] [--strict-allocations <warmup frames>]\n"
+    "            [--allocation-sites] [command]\n"
+    "commands, playing when there is none:\n"
+    "  --bench-enemies [count [threads]]\n"
+    "  --bench-broadphase [count]\n"
+    "  --bench-trig [count]\n"
+    "  --bench-particles [count]\n"
+    "  --bench-raycast [count]\n"
+    "  --bench-seek <replay> [seeks [first segment [segments]]]\n"
+    "  --record <replay> [keyframe interval]\n"
+    "  --record-bot <replay> <frames> [seed [keyframe interval]]\n"
+    "  --write-map <file> <rows> <cols> [seed]\n"
+    "  --capture <file>\n"
+    "  --capture-replay <replay> <file> [first frame [frames]]\n"
+    "  --netplay <local port> <remote host> <remote port> <player 1|2>\n"
+    "      [input delay]\n"
+    "  --netplay-loopback [latency [loss percent]]\n"
+    "  --scenario <file>\n";
+
+// Parses a whole decimal argument in [min, max]. Throws std::runtime_error
+// naming |name| for anything else, rather than letting a typo or a minus
+// sign turn into a huge count.
+uint64_t parseNumber(const char* text, const char* name,
+        uint64_t min, uint64_t max)
+{
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (!std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' ||
+            errno == ERANGE || value < min || value > max) {
+        throw std::runtime_error(std::string("Expected ") + name +
+                " from " + std::to_string(min) + " to " + std::to_string(max) +
+                ", got '" + text + "'");
+    }
+    return value;
+}
+
+// Counts of things the benchmarks allocate and loop over
+std::size_t parseCount(const char* text, const char* name)
+{
+    return parseNumber(text, name, 0, std::numeric_limits<int>::max());
+}
+
+// A share from 0 to 100 percent, as a fraction
+double parsePercent(const char* text, const char* name)
+{
+    char* end = nullptr;
+    const double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0.0 && value <= 100.0)) {
+        throw std::runtime_error(std::string("Expected ") + name +
+                " from 0 to 100, got '" + text + "'");
+    }
+    return value / 100.0;
+}
+
+// Frame numbers and counts of frames or segments
+units::Frame parseFrames(const char* text, const char* name)
 {
+    return parseNumber(text, name, 0, kMaxFrames);
+}
+
+int run(int argc, char* argv[])
+{
+    // cave --bench-enemies [count [threads]]
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-enemies") == 0) {
+        const std::size_t count =
+            (argc >= 3) ? parseCount(argv[2], "enemy count") : 10000;
+        const std::size_t threads =
+            (argc >= 4) ? parseCount(argv[3], "thread count") : 0;
+        benchmark::runEnemies(count, kBenchmarkFrames, threads);
+        return 0;
+    }
+    // cave --bench-broadphase [count]
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-broadphase") == 0) {
+        const std::size_t count =
+            (argc >= 3) ? parseCount(argv[2], "enemy count") : 10000;
+        benchmark::runBroadphase(count, kBenchmarkFrames);
+        return 0;
+    }
+    // cave --bench-trig [count]
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-trig") == 0) {
+        const std::size_t count =
+            (argc >= 3) ? parseCount(argv[2], "angle count") : 100000;
+        benchmark::runTrig(count, kBenchmarkFrames);
+        return 0;
+    }
+    // cave --bench-particles [count]
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-particles") == 0) {
+        const std::size_t count =
+            (argc >= 3) ? parseCount(argv[2], "particle count") : 100000;
+        benchmark::runParticles(count, kBenchmarkFrames);
+        return 0;
+    }
+    // cave --bench-raycast [count]
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-raycast") == 0) {
+        const std::size_t count =
+            (argc >= 3) ? parseCount(argv[2], "ray count") : 100000;
+        benchmark::runRaycasts(count, kBenchmarkFrames);
+        return 0;
+    }
+
+    // cave --bench-seek <replay> [seeks [first segment [segments]]]
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-seek") == 0) {
+        SeekBenchmark benchmark;
+        if (argc >= 4) {
+            benchmark.num_seeks = parseCount(argv[3], "seek count");
+        }
+        if (argc >= 5) {
+            benchmark.first_segment = parseFrames(argv[4], "first segment");
+        }
+        if (argc >= 6) {
+            benchmark.num_segments = parseFrames(argv[5], "segment count");
+        }
+        Game game(Replay::load(argv[2]), benchmark);
+        return 0;
+    }
+
+    // cave --record <replay> [keyframe interval]
+    if (argc >= 3 && std::strcmp(argv[1], "--record") == 0) {
+        RecordConfig config;
+        config.file_path = argv[2];
+        if (argc >= 4) {
+            config.keyframe_interval =
+                parseNumber(argv[3], "keyframe interval", 1, kMaxFrames);
+        }
+        Game game(config);
+        return 0;
+    }
+    // cave --record-bot <replay> <frames> [seed [keyframe interval]]
+    if (argc >= 4 && std::strcmp(argv[1], "--record-bot") == 0) {
+        RecordConfig config;
+        config.file_path = argv[2];
+        config.bot_frames = parseNumber(argv[3], "frame count", 1, kMaxFrames);
+        if (argc >= 5) {
+            config.seed = parseNumber(argv[4], "seed",
+                    0, std::numeric_limits<uint64_t>::max());
+        }
+        if (argc >= 6) {
+            config.keyframe_interval =
+                parseNumber(argv[5], "keyframe interval", 1, kMaxFrames);
+        }
+        Game game(config);
+        return 0;
+    }
+
+    // cave --write-map <file> <rows> <cols> [seed]
+    if (argc >= 5 && std::strcmp(argv[1], "--write-map") == 0) {
+        const units::Tile rows = parseNumber(argv[3], "row count",
+                Map::kMinCaveSize, Map::kMaxCaveSize);
+        const units::Tile cols = parseNumber(argv[4], "column count",
+                Map::kMinCaveSize, Map::kMaxCaveSize);
+        const unsigned seed = (argc >= 6) ? parseNumber(argv[5], "seed",
+                0, std::numeric_limits<unsigned>::max()) : 1;
+        const SDLEngine sdl_engine(0);
+        Graphics graphics(Graphics::Output::OFFSCREEN);
+        Map::createCaveMap(graphics, rows, cols, seed)->save(argv[2]);
+        std::cout << "map: " << rows << " x " << cols
+            << " tiles written to '" << argv[2] << "'\n";
+        return 0;
+    }
+
+    // cave --capture <file>
+    if (argc >= 3 && std::strcmp(argv[1], "--capture") == 0) {
+        CaptureConfig config;
+        config.file_path = argv[2];
+        Game game(config);
+        return 0;
+    }
+    // cave --capture-replay <replay> <file> [first frame [frames]]
+    if (argc >= 4 && std::strcmp(argv[1], "--capture-replay") == 0) {
+        CaptureConfig config;
+        config.file_path = argv[3];
+        if (argc >= 5) {
+            config.first_frame = parseFrames(argv[4], "first frame");
+        }
+        if (argc >= 6) {
+            config.num_frames = parseFrames(argv[5], "frame count");
+        }
+        Game game(Replay::load(argv[2]), config);
+        return 0;
+    }
+
+    // cave --netplay <local port> <remote host> <remote port> <player 1|2>
+    //     [input delay]
+    if (argc >= 6 && std::strcmp(argv[1], "--netplay") == 0) {
+        NetplayConfig config;
+        config.local_port = parseNumber(argv[2], "local port", 1, 65535);
+        config.remote_host = argv[3];
+        config.remote_port = parseNumber(argv[4], "remote port", 1, 65535);
+        config.local_player = parseNumber(argv[5], "player", 1, 2) - 1;
+        if (argc >= 7) {
+            config.input_delay = parseNumber(argv[6], "input delay",
+                    0, kMaxInputDelay);
+        }
+        Game game(config);
+        return 0;
+    }
+    // cave --netplay-loopback [latency [loss percent]]
+    if (argc >= 2 && std::strcmp(argv[1], "--netplay-loopback") == 0) {
+        NetplayConfig config;
+        config.loopback = true;
+        if (argc >= 3) {
+            config.latency = std::chrono::milliseconds{
+                parseNumber(argv[2], "latency", 0, kMaxLatency)};
+        }
+        if (argc >= 4) {
+            config.loss = parsePercent(argv[3], "loss percent");
+        }
+        Game game(config);
+        return 0;
+    }
+
+    // cave --scenario <file>
+    if (argc >= 3 && std::strcmp(argv[1], "--scenario") == 0) {
+        Game game(Scenario::load(argv[2]));
+        return 0;
+    }
+
     Game game;
 
     std::cout << "Bye!\n";
     return 0;
 }
+
+// The command line without the |count| arguments after the program name
+std::vector<char*> skipArguments(int argc, char* argv[], int count)
+{
+    std::vector<char*> args{argv[0]};
+    args.insert(args.end(), argv + 1 + count, argv + argc);
+    return args;
+}
+
+// Takes the options that wrap any other command line, then runs the rest
+int start(int argc, char* argv[])
+{
+    // cave --trace <file> [any other options]
+    if (argc >= 3 && std::strcmp(argv[1], "--trace") == 0) {
+        auto args = skipArguments(argc, argv, 2);
+        trace::setThreadName("main");
+        trace::start();
+        const int result = start(args.size(), args.data());
+        trace::stop();
+        trace::write(argv[2]);
+        std::cout << "trace: written to '" << argv[2] << "'\n";
+        return result;
+    }
+    // cave --strict-allocations <warmup frames> [any other options]
+    if (argc >= 3 && std::strcmp(argv[1], "--strict-allocations") == 0) {
+        setStrictAllocations(parseFrames(argv[2], "warmup frames"));
+        auto args = skipArguments(argc, argv, 2);
+        return start(args.size(), args.data());
+    }
+    // cave --allocation-sites [any other options]
+    if (argc >= 2 && std::strcmp(argv[1], "--allocation-sites") == 0) {
+        auto args = skipArguments(argc, argv, 1);
+        const int result = start(args.size(), args.data());
+        std::cout << "allocation sites:\n";
+        reportAllocationSites(std::cout, kNumAllocationSites);
+        return result;
+    }
+    return run(argc, argv);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    // Bad arguments and unreadable files end here rather than in
+    // std::terminate()
+    try {
+        return start(argc, argv);
+    } catch (const std::runtime_error& error) {
+        std::cerr << "cave: " << error.what() << "\n" << kUsage;
+        return 1;
+    }
+}
@@ -1,23 +1,61 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
 #include "map.h"
+#include "config.h"
 #include "game.h"
 #include "graphics.h"
+#include "map_file.h"
+#include "map_streamer.h"
+#include "trace.h"
 #include "rectangle.h"
-#include "sprite.h"
+#include "rng.h"
 #include "vector.h"
 
 const std::string kMapSpriteFilePath{"PrtCave"};
 
+namespace {
+
+// units::gameToTile() wraps around for negative positions; rectangles may
+// hang off the top/left edge of the map, so keep the sign here.
+int gameToSignedTile(units::Game game)
+{
+    return static_cast<int>(std::floor(game / units::tileToGame(1)));
+}
+
+units::Tile clampTile(int tile, units::Tile num_tiles)
+{
+    return static_cast<units::Tile>(
+            std::min(std::max(tile, 0), static_cast<int>(num_tiles)));
+}
+
+} // anonymous namespace
+
+const units::Tile Map::kMinCaveSize;
+const units::Tile Map::kMaxCaveSize;
+const units::Tile Map::kBitsPerWord;
+
 Map::Map() :
     backdrop_(),
-    background_tiles_(),
-    tiles_()
+    num_rows_{0},
+    num_cols_{0},
+    words_per_row_{0},
+    wall_bits_(),
+    tileset_(1),
+    chunk_rows_{0},
+    chunk_cols_{0},
+    chunks_(),
+    streamer_(),
+    view_{0, 0, 0, 0}
 {}
 
 Map::~Map() {}
 
 std::unique_ptr<Map> Map::createTestMap(Graphics& graphics)
 {
-    using std::vector;
     auto map = std::make_unique<Map>();
 
     const std::string bkPath{"bkBlue"};
@@ -25,116 +63,368 @@ std::unique_ptr<Map> Map::createTestMap(Graphics& graphics)
 
     const units::Tile num_rows{15}; // 15 * 32 == 480
     const units::Tile num_cols{20}; // 20 * 32 == 640
-    // Ensure tiles_ and background_tiles_ is num_rows x num_cols in size
-    map->tiles_ = vector<vector<Tile> >(
-            num_rows, vector<Tile>(
-                num_cols, Tile()));
-
-    map->background_tiles_ = vector<vector<std::shared_ptr<Sprite> > >(
-            num_rows, vector<std::shared_ptr<Sprite> >(
-                num_cols, std::shared_ptr<Sprite>()));
-
-    auto sprite = std::make_shared<Sprite>(
-            graphics,
-            kMapSpriteFilePath,
-            units::tileToPixel(1), units::tileToPixel(0),
-            units::tileToPixel(1), units::tileToPixel(1));
-    Tile tile(TileType::WALL, sprite);
+    map->resize(num_rows, num_cols);
+
+    const SpriteId rock = map->addTileSprite(graphics, 1, 0);
     const units::Tile row{11};
     for (units::Tile col = 0; col < num_cols; ++col) {
-        map->tiles_[row][col] = tile;
-    }
-    map->tiles_[10][5] = tile;
-    map->tiles_[8][5] = tile;
-    map->tiles_[9][4] = tile;
-    map->tiles_[8][3] = tile;
-    map->tiles_[7][2] = tile;
-    map->tiles_[10][3] = tile;
-
-    map->tiles_[10][0] = tile;
-    map->tiles_[9][0] = tile;
-    map->tiles_[8][0] = tile;
-    map->tiles_[7][0] = tile;
-    map->tiles_[6][0] = tile;
-    map->tiles_[5][0] = tile;
-    map->tiles_[4][0] = tile;
-    map->tiles_[3][0] = tile;
-    map->tiles_[10][19] = tile;
-    map->tiles_[9][19] = tile;
-    map->tiles_[8][19] = tile;
-    map->tiles_[7][19] = tile;
-
-    auto chain_top = std::make_shared<Sprite>(
-            graphics,
-            kMapSpriteFilePath,
-            units::tileToPixel(11), units::tileToPixel(2),
-            units::tileToPixel(1), units::tileToPixel(1));
-    auto chain_middle = std::make_shared<Sprite>(
-            graphics,
-            kMapSpriteFilePath,
-            units::tileToPixel(12), units::tileToPixel(2),
-            units::tileToPixel(1), units::tileToPixel(1));
-    auto chain_bottom = std::make_shared<Sprite>(
-            graphics,
-            kMapSpriteFilePath,
-            units::tileToPixel(13), units::tileToPixel(2),
-            units::tileToPixel(1), units::tileToPixel(1));
-
-    map->background_tiles_[8][2] = chain_top;
-    map->background_tiles_[9][2] = chain_middle;
-    map->background_tiles_[10][2] = chain_bottom;
+        map->setTile(row, col, TileType::WALL, rock);
+    }
+    map->setTile(10, 5, TileType::WALL, rock);
+    map->setTile(8, 5, TileType::WALL, rock);
+    map->setTile(9, 4, TileType::WALL, rock);
+    map->setTile(8, 3, TileType::WALL, rock);
+    map->setTile(7, 2, TileType::WALL, rock);
+    map->setTile(10, 3, TileType::WALL, rock);
+
+    map->setTile(10, 0, TileType::WALL, rock);
+    map->setTile(9, 0, TileType::WALL, rock);
+    map->setTile(8, 0, TileType::WALL, rock);
+    map->setTile(7, 0, TileType::WALL, rock);
+    map->setTile(6, 0, TileType::WALL, rock);
+    map->setTile(5, 0, TileType::WALL, rock);
+    map->setTile(4, 0, TileType::WALL, rock);
+    map->setTile(3, 0, TileType::WALL, rock);
+    map->setTile(10, 19, TileType::WALL, rock);
+    map->setTile(9, 19, TileType::WALL, rock);
+    map->setTile(8, 19, TileType::WALL, rock);
+    map->setTile(7, 19, TileType::WALL, rock);
+
+    const SpriteId chain_top = map->addTileSprite(graphics, 11, 2);
+    const SpriteId chain_middle = map->addTileSprite(graphics, 12, 2);
+    const SpriteId chain_bottom = map->addTileSprite(graphics, 13, 2);
+
+    map->setBackgroundTile(8, 2, chain_top);
+    map->setBackgroundTile(9, 2, chain_middle);
+    map->setBackgroundTile(10, 2, chain_bottom);
+
+    return map;
+}
+
+std::unique_ptr<Map> Map::createCaveMap(Graphics& graphics,
+        units::Tile num_rows, units::Tile num_cols, unsigned seed)
+{
+    if (num_rows < kMinCaveSize || num_cols < kMinCaveSize ||
+            num_rows > kMaxCaveSize || num_cols > kMaxCaveSize) {
+        throw std::runtime_error("Cave map needs 3 x 3 to 8192 x 8192 tiles");
+    }
+    auto map = std::make_unique<Map>();
+
+    const std::string bkPath{"bkBlue"};
+    map->backdrop_ = std::make_unique<FixedBackdrop>(bkPath, graphics);
+    map->resize(num_rows, num_cols);
+
+    const SpriteId rock = map->addTileSprite(graphics, 1, 0);
+    for (units::Tile col = 0; col < num_cols; ++col) {
+        map->setTile(0, col, TileType::WALL, rock);
+        map->setTile(num_rows - 1, col, TileType::WALL, rock);
+    }
+    for (units::Tile row = 0; row < num_rows; ++row) {
+        map->setTile(row, 0, TileType::WALL, rock);
+        map->setTile(row, num_cols - 1, TileType::WALL, rock);
+    }
+
+    // Every fourth row, ledges of 2 to 8 tiles with gaps of up to 12
+    Rng random(seed);
+    for (units::Tile row = 4; row + 1 < num_rows; row += 4) {
+        units::Tile col = random.between(1, 12);
+        while (col + 1 < num_cols) {
+            const units::Tile end = std::min(col + random.between(2, 8),
+                    num_cols - 1);
+            for (; col < end; ++col) {
+                map->setTile(row, col, TileType::WALL, rock);
+            }
+            col += random.between(1, 12);
+        }
+    }
 
     return map;
 }
 
+std::unique_ptr<Map> Map::load(Graphics& graphics,
+        const std::string& file_path)
+{
+    auto map = std::make_unique<Map>();
+
+    const std::string bkPath{"bkBlue"};
+    map->backdrop_ = std::make_unique<FixedBackdrop>(bkPath, graphics);
+
+    map->streamer_ = std::make_unique<MapStreamer>(
+            file_path, config::getMapMemoryBudget());
+    const MapFileHeader& header = map->streamer_->getHeader();
+    map->resize(header.num_rows, header.num_cols);
+
+    std::vector<MapFileTile> tileset(header.num_tileset);
+    map->streamer_->read(header.tileset_offset,
+            tileset.size() * sizeof(MapFileTile), tileset.data());
+    for (std::size_t i = 1; i < tileset.size(); ++i) {
+        map->addTileSprite(graphics,
+                tileset[i].source_col, tileset[i].source_row);
+    }
+    map->streamer_->read(header.wall_bits_offset,
+            map->wall_bits_.size() * sizeof(WallBits),
+            map->wall_bits_.data());
+
+    return map;
+}
+
+void Map::save(const std::string& file_path) const
+{
+    if (streamer_) {
+        throw std::runtime_error("Cannot save a streamed map!");
+    }
+
+    std::vector<MapFileTile> tileset;
+    for (const auto& tile_sprite : tileset_) {
+        tileset.push_back(MapFileTile{
+                static_cast<uint16_t>(tile_sprite.source_col),
+                static_cast<uint16_t>(tile_sprite.source_row)});
+    }
+
+    std::vector<uint8_t> chunk_data;
+    std::vector<MapFileChunk> chunk_table(chunks_.size());
+    for (std::size_t i = 0; i < chunks_.size(); ++i) {
+        chunk_table[i].offset = chunk_data.size();
+        encodeChunk(*chunks_[i], chunk_data);
+        chunk_table[i].size = chunk_data.size() - chunk_table[i].offset;
+        chunk_table[i].reserved = 0;
+    }
+
+    const auto align = [](uint64_t offset) { return (offset + 7) & ~7ull; };
+    MapFileHeader header;
+    std::memcpy(header.magic, kMapFileMagic, sizeof(kMapFileMagic));
+    header.num_rows = num_rows_;
+    header.num_cols = num_cols_;
+    header.chunk_size = kChunkSize;
+    header.num_tileset = tileset.size();
+    header.tileset_offset = align(sizeof(header));
+    header.wall_bits_offset = align(
+            header.tileset_offset + tileset.size() * sizeof(MapFileTile));
+    header.chunk_table_offset = align(
+            header.wall_bits_offset + wall_bits_.size() * sizeof(WallBits));
+    const uint64_t chunk_data_offset =
+        header.chunk_table_offset + chunk_table.size() * sizeof(MapFileChunk);
+    for (auto& entry : chunk_table) {
+        entry.offset += chunk_data_offset;
+    }
+
+    std::ofstream file(file_path, std::ios::binary);
+    const auto write_at = [&file](uint64_t offset, const void* data,
+            std::size_t size) {
+        file.seekp(offset);
+        file.write(static_cast<const char*>(data), size);
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.tileset_offset, tileset.data(),
+            tileset.size() * sizeof(MapFileTile));
+    write_at(header.wall_bits_offset, wall_bits_.data(),
+            wall_bits_.size() * sizeof(WallBits));
+    write_at(header.chunk_table_offset, chunk_table.data(),
+            chunk_table.size() * sizeof(MapFileChunk));
+    write_at(chunk_data_offset, chunk_data.data(), chunk_data.size());
+    if (!file) {
+        throw std::runtime_error("Cannot write map '" + file_path + "'!");
+    }
+}
+
+void Map::update(const Rectangle& view)
+{
+    view_ = getTileRange(view);
+    if (!streamer_) {
+        return;
+    }
+    const units::Tile first_row = view_.first_row / kChunkSize;
+    const units::Tile first_col = view_.first_col / kChunkSize;
+    const units::Tile end_row = (view_.end_row + kChunkSize - 1) / kChunkSize;
+    const units::Tile end_col = (view_.end_col + kChunkSize - 1) / kChunkSize;
+    streamer_->update(ChunkRange{
+            first_row > 0 ? first_row - 1 : 0,
+            std::min(end_row + 1, chunk_rows_),
+            first_col > 0 ? first_col - 1 : 0,
+            std::min(end_col + 1, chunk_cols_)});
+}
 
 const std::vector<Map::CollisionTile>
 Map::getCollidingTiles(const Rectangle& rect) const
 {
-    const units::Tile first_row = units::gameToTile(rect.getTop());
-    const units::Tile last_row = units::gameToTile(rect.getBottom());
-    const units::Tile first_col = units::gameToTile(rect.getLeft());
-    const units::Tile last_col = units::gameToTile(rect.getRight());
-    // TODO: throw exception if we fall off the screen
+    TRACE_ZONE("Map::getCollidingTiles");
     std::vector<CollisionTile> collision_tiles;
+    forEachCollidingTile(rect, [&collision_tiles](const CollisionTile& tile) {
+        collision_tiles.push_back(tile);
+    });
+    return collision_tiles;
+}
 
-    for (units::Tile row = first_row; row <= last_row; ++row) {
-        for (units::Tile col = first_col; col <= last_col; ++col) {
-            collision_tiles.push_back(
-                    CollisionTile(row, col, tiles_[row][col].tile_type));
+Map::CollisionInfo Map::getWallCollisionInfo(const Rectangle& rect) const
+{
+    TRACE_ZONE("Map::getWallCollisionInfo");
+    const TileRange range = getTileRange(rect);
+    if (range.first_col >= range.end_col) {
+        return CollisionInfo{false, 0, 0};
+    }
+    const units::Tile first_word = range.first_col / kBitsPerWord;
+    const units::Tile end_word = (range.end_col - 1) / kBitsPerWord + 1;
+    for (units::Tile row = range.first_row; row < range.end_row; ++row) {
+        const WallBits* words = wallRow(row);
+        for (units::Tile word = first_word; word < end_word; ++word) {
+            const WallBits bits = words[word] &
+                columnMask(word, range.first_col, range.end_col);
+            if (bits != 0) {
+                return CollisionInfo{true, row,
+                    word * kBitsPerWord + __builtin_ctzll(bits)};
+            }
         }
     }
+    return CollisionInfo{false, 0, 0};
+}
 
-    return collision_tiles;
+Map::TileType Map::getTileType(units::Tile row, units::Tile col) const
+{
+    if (row >= num_rows_ || col >= num_cols_) {
+        return TileType::AIR;
+    }
+    return isWall(row, col) ? TileType::WALL : TileType::AIR;
 }
 
-void Map::drawBackground(Graphics& graphics) const
+units::Tile Map::getNumRows() const
 {
-    backdrop_->draw(graphics);
-    for (auto row = 0u; row < background_tiles_.size(); ++row) {
-        for (auto col = 0u; col < background_tiles_[row].size(); ++col) {
-            if (background_tiles_[row][col] != nullptr) {
-                Vector<units::Game> pos{
-                    units::tileToGame(col),
-                    units::tileToGame(row)
-                };
-                background_tiles_[row][col]->draw(graphics, pos);
-            }
+    return num_rows_;
+}
+
+units::Tile Map::getNumCols() const
+{
+    return num_cols_;
+}
+
+Map::TileRange Map::getTileRange(const Rectangle& rect) const
+{
+    return TileRange{
+        clampTile(gameToSignedTile(rect.getTop()), num_rows_),
+        clampTile(gameToSignedTile(rect.getBottom()) + 1, num_rows_),
+        clampTile(gameToSignedTile(rect.getLeft()), num_cols_),
+        clampTile(gameToSignedTile(rect.getRight()) + 1, num_cols_)
+    };
+}
+
+Map::WallBits Map::columnMask(units::Tile word,
+        units::Tile first_col, units::Tile end_col)
+{
+    const units::Tile word_start = word * kBitsPerWord;
+    const units::Tile low = std::max(first_col, word_start) - word_start;
+    const units::Tile high =
+        std::min(end_col, word_start + kBitsPerWord) - word_start;
+    const WallBits below_high = (high == kBitsPerWord)
+        ? ~WallBits{0}
+        : (WallBits{1} << high) - 1;
+    return below_high & ~((WallBits{1} << low) - 1);
+}
+
+const Map::WallBits* Map::wallRow(units::Tile row) const
+{
+    return &wall_bits_[row * words_per_row_];
+}
+
+SpriteId Map::addTileSprite(Graphics& graphics,
+        units::Tile source_col, units::Tile source_row)
+{
+    if (tileset_.size() > std::numeric_limits<SpriteId>::max()) {
+        throw std::runtime_error("Too many map tile sprites!");
+    }
+    tileset_.push_back(TileSprite{source_col, source_row,
+            graphics.getSpriteRegistry().add(
+                kMapSpriteFilePath,
+                units::tileToPixel(source_col), units::tileToPixel(source_row),
+                units::tileToPixel(1), units::tileToPixel(1))});
+    return tileset_.size() - 1;
+}
+
+void Map::resize(units::Tile num_rows, units::Tile num_cols)
+{
+    num_rows_ = num_rows;
+    num_cols_ = num_cols;
+    words_per_row_ = (num_cols + kBitsPerWord - 1) / kBitsPerWord;
+    wall_bits_.assign(num_rows * words_per_row_, 0);
+
+    chunk_rows_ = (num_rows + kChunkSize - 1) / kChunkSize;
+    chunk_cols_ = (num_cols + kChunkSize - 1) / kChunkSize;
+    chunks_.clear();
+    if (!streamer_) {
+        for (units::Tile i = 0; i < chunk_rows_ * chunk_cols_; ++i) {
+            chunks_.push_back(std::make_unique<MapChunk>());
+            std::fill_n(&chunks_.back()->sprites[0][0],
+                    MapChunk::NUM_LAYERS * kChunkTiles, kNoSprite);
         }
     }
+
+    view_ = getTileRange(Rectangle(0, 0,
+                units::tileToGame(Game::kScreenWidth),
+                units::tileToGame(Game::kScreenHeight)));
 }
 
-void Map::draw(Graphics& graphics) const
+void Map::setTile(units::Tile row, units::Tile col,
+        TileType tile_type, SpriteId sprite)
+{
+    MapChunk& chunk =
+        *chunks_[row / kChunkSize * chunk_cols_ + col / kChunkSize];
+    chunk.sprites[MapChunk::FOREGROUND]
+        [row % kChunkSize * kChunkSize + col % kChunkSize] = sprite;
+
+    WallBits& word = wall_bits_[row * words_per_row_ + col / kBitsPerWord];
+    const WallBits bit = WallBits{1} << (col % kBitsPerWord);
+    if (tile_type == TileType::WALL) {
+        word |= bit;
+    } else {
+        word &= ~bit;
+    }
+}
+
+void Map::setBackgroundTile(units::Tile row, units::Tile col, SpriteId sprite)
+{
+    MapChunk& chunk =
+        *chunks_[row / kChunkSize * chunk_cols_ + col / kChunkSize];
+    chunk.sprites[MapChunk::BACKGROUND]
+        [row % kChunkSize * kChunkSize + col % kChunkSize] = sprite;
+}
+
+const MapChunk* Map::getChunk(units::Tile chunk_row,
+        units::Tile chunk_col) const
 {
-    for (auto row = 0u; row < tiles_.size(); ++row) {
-        for (auto col = 0u; col < tiles_[row].size(); ++col) {
-            if (tiles_[row][col].sprite != nullptr) {
+    if (streamer_) {
+        return streamer_->getChunk(chunk_row, chunk_col);
+    }
+    return chunks_[chunk_row * chunk_cols_ + chunk_col].get();
+}
+
+void Map::drawLayer(Graphics& graphics, MapChunk::Layer layer) const
+{
+    const SpriteRegistry& sprites = graphics.getSpriteRegistry();
+    for (auto row = view_.first_row; row < view_.end_row; ++row) {
+        for (auto col = view_.first_col; col < view_.end_col; ++col) {
+            const MapChunk* chunk =
+                getChunk(row / kChunkSize, col / kChunkSize);
+            if (chunk == nullptr) {
+                continue;
+            }
+            const SpriteId sprite = chunk->sprites[layer]
+                [row % kChunkSize * kChunkSize + col % kChunkSize];
+            if (sprite != kNoSprite && sprite < tileset_.size()) {
                 Vector<units::Game> pos{
                     units::tileToGame(col),
                     units::tileToGame(row)
                 };
-                tiles_[row][col].sprite->draw(graphics, pos);
+                sprites.draw(tileset_[sprite].sprite, pos);
             }
         }
     }
 }
+
+void Map::drawBackground(Graphics& graphics) const
+{
+    backdrop_->draw(graphics);
+    drawLayer(graphics, MapChunk::BACKGROUND);
+}
+
+void Map::draw(Graphics& graphics) const
+{
+    drawLayer(graphics, MapChunk::FOREGROUND);
+}
@@ -2,13 +2,18 @@
 #define MAP_H_
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include "backdrop.h"
+#include "map_chunk.h"
+#include "sprite_registry.h"
 #include "units.h"
 
 struct Graphics;
-struct Sprite;
+struct MapStreamer;
 struct Rectangle;
 
 struct Map {
@@ -31,27 +36,154 @@ struct Map {
        TileType tile_type;
    };
 
+   struct CollisionInfo {
+       bool collided;
+       units::Tile row;
+       units::Tile col;
+   };
+
+   // Smallest and largest side of a cave map; the largest keeps its tile
+   // sprites within 256 MiB
+   static const units::Tile kMinCaveSize{3};
+   static const units::Tile kMaxCaveSize{8192};
+
    static std::unique_ptr<Map> createTestMap(Graphics& graphics);
+   // A walled |num_rows| x |num_cols| cave with ledges scattered through
+   // it; the same |seed| always gives the same map.
+   static std::unique_ptr<Map> createCaveMap(Graphics& graphics,
+           units::Tile num_rows, units::Tile num_cols, unsigned seed);
+   // Opens a map file written by save(). Only the wall bitmask is loaded up
+   // front; tile sprites are streamed in chunks around the view, within
+   // config::getMapMemoryBudget().
+   static std::unique_ptr<Map> load(Graphics& graphics,
+           const std::string& file_path);
+   // Writes a map built in memory; throws std::runtime_error on failure.
+   void save(const std::string& file_path) const;
 
+   // Streams in the chunks around |view| (with a one chunk margin) and
+   // remembers it as the area to draw.
+   void update(const Rectangle& view);
+
+   // Convenience wrapper around forEachCollidingTile(); allocates, so keep it
+   // out of per-frame code.
    const std::vector<CollisionTile>
        getCollidingTiles(const Rectangle& rect) const;
 
+   // Calls visitor(const CollisionTile&) for every tile |rect| overlaps.
+   // Tiles outside of the map are skipped.
+   template <typename Visitor>
+   void forEachCollidingTile(const Rectangle& rect, Visitor visitor) const;
+
+   // Like forEachCollidingTile() but only visits WALL tiles, found by
+   // scanning the solidity bitmask rather than the tiles themselves.
+   template <typename Visitor>
+   void forEachWallTile(const Rectangle& rect, Visitor visitor) const;
+
+   // Returns the first WALL tile |rect| overlaps (scanning rows top to
+   // bottom, columns left to right) without visiting the rest.
+   CollisionInfo getWallCollisionInfo(const Rectangle& rect) const;
+
+   // Tiles outside of the map are reported as AIR.
+   TileType getTileType(units::Tile row, units::Tile col) const;
+   units::Tile getNumRows() const;
+   units::Tile getNumCols() const;
+
    void drawBackground(Graphics& graphics) const;
    void draw(Graphics& graphics) const;
 private:
-   struct Tile {
-       Tile(TileType tile_type=TileType::AIR,
-               std::shared_ptr<Sprite> sprite=std::shared_ptr<Sprite>()) :
-           tile_type(tile_type),
-           sprite(sprite)
-       {}
+   // Half-open range of tiles covered by a rectangle, clamped to the map
+   struct TileRange {
+       units::Tile first_row;
+       units::Tile end_row;
+       units::Tile first_col;
+       units::Tile end_col;
+   };
+   TileRange getTileRange(const Rectangle& rect) const;
 
-       TileType tile_type;
-       std::shared_ptr<Sprite> sprite;
+   // One bit per tile, set for WALL tiles; each row starts on a new word.
+   // The bitmask always covers the whole map, so collision never depends on
+   // which chunks are resident.
+   typedef uint64_t WallBits;
+   static const units::Tile kBitsPerWord{64};
+   // Bits of word |word| that fall into columns [first_col, end_col)
+   static WallBits columnMask(units::Tile word,
+           units::Tile first_col, units::Tile end_col);
+   const WallBits* wallRow(units::Tile row) const;
+   bool isWall(units::Tile row, units::Tile col) const;
+
+   struct TileSprite {
+       units::Tile source_col;
+       units::Tile source_row;
+       SpriteRegistry::Id sprite;
    };
+   SpriteId addTileSprite(Graphics& graphics,
+           units::Tile source_col, units::Tile source_row);
+
+   // Building maps in memory
+   void resize(units::Tile num_rows, units::Tile num_cols);
+   void setTile(units::Tile row, units::Tile col,
+           TileType tile_type, SpriteId sprite);
+   void setBackgroundTile(units::Tile row, units::Tile col, SpriteId sprite);
+
+   // Returns nullptr for chunks that are not streamed in yet
+   const MapChunk* getChunk(units::Tile chunk_row, units::Tile chunk_col) const;
+   void drawLayer(Graphics& graphics, MapChunk::Layer layer) const;
+
    std::unique_ptr<Backdrop> backdrop_;
-   std::vector<std::vector<std::shared_ptr<Sprite> > > background_tiles_;
-   std::vector<std::vector<Tile> >tiles_;
+   units::Tile num_rows_;
+   units::Tile num_cols_;
+   units::Tile words_per_row_;
+   std::vector<WallBits> wall_bits_;
+   // Index 0 is kNoSprite
+   std::vector<TileSprite> tileset_;
+   units::Tile chunk_rows_;
+   units::Tile chunk_cols_;
+   // Every chunk of a map built in memory; empty for streamed maps
+   std::vector<std::unique_ptr<MapChunk> > chunks_;
+   std::unique_ptr<MapStreamer> streamer_;
+   TileRange view_;
 };
 
+template <typename Visitor>
+void Map::forEachCollidingTile(const Rectangle& rect, Visitor visitor) const
+{
+    const TileRange range = getTileRange(rect);
+    for (units::Tile row = range.first_row; row < range.end_row; ++row) {
+        for (units::Tile col = range.first_col; col < range.end_col; ++col) {
+            visitor(CollisionTile(row, col,
+                        isWall(row, col) ? TileType::WALL : TileType::AIR));
+        }
+    }
+}
+
+template <typename Visitor>
+void Map::forEachWallTile(const Rectangle& rect, Visitor visitor) const
+{
+    const TileRange range = getTileRange(rect);
+    if (range.first_col >= range.end_col) {
+        return;
+    }
+    const units::Tile first_word = range.first_col / kBitsPerWord;
+    const units::Tile end_word = (range.end_col - 1) / kBitsPerWord + 1;
+    for (units::Tile row = range.first_row; row < range.end_row; ++row) {
+        const WallBits* words = wallRow(row);
+        for (units::Tile word = first_word; word < end_word; ++word) {
+            WallBits bits = words[word] &
+                columnMask(word, range.first_col, range.end_col);
+            while (bits != 0) {
+                const units::Tile col =
+                    word * kBitsPerWord + __builtin_ctzll(bits);
+                visitor(CollisionTile(row, col, TileType::WALL));
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+inline bool Map::isWall(units::Tile row, units::Tile col) const
+{
+    const WallBits word = wallRow(row)[col / kBitsPerWord];
+    return (word >> (col % kBitsPerWord)) & 1;
+}
+
 #endif /* MAP_H_ */
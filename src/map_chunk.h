@@ -0,0 +1,34 @@
+#ifndef MAP_CHUNK_H_
+#define MAP_CHUNK_H_
+
+#include <cstdint>
+#include "units.h"
+
+// Index into the map tileset; 0 means the tile has no sprite.
+typedef uint16_t SpriteId;
+const SpriteId kNoSprite{0};
+
+const units::Tile kChunkSize{32};
+const units::Tile kChunkTiles{kChunkSize * kChunkSize};
+
+// Sprites of a kChunkSize x kChunkSize block of the map, row-major.
+// Collision does not live here: Map keeps the wall bitmask for the whole
+// map resident, so a chunk can be dropped without changing physics.
+struct MapChunk {
+    enum Layer {
+        BACKGROUND,
+        FOREGROUND,
+        NUM_LAYERS
+    };
+    SpriteId sprites[NUM_LAYERS][kChunkTiles];
+};
+
+// Half-open range of chunks
+struct ChunkRange {
+    units::Tile first_row;
+    units::Tile end_row;
+    units::Tile first_col;
+    units::Tile end_col;
+};
+
+#endif /* MAP_CHUNK_H_ */
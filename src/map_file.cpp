@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cstring>
+#include "map_file.h"
+
+const char kMapFileMagic[8] = {'C', 'A', 'V', 'E', 'M', 'A', 'P', '1'};
+
+namespace {
+
+void appendRun(uint16_t count, SpriteId sprite, std::vector<uint8_t>& out)
+{
+    const uint16_t run[2] = {count, sprite};
+    const auto bytes = reinterpret_cast<const uint8_t*>(run);
+    out.insert(out.end(), bytes, bytes + sizeof(run));
+}
+
+} // anonymous namespace
+
+void encodeChunk(const MapChunk& chunk, std::vector<uint8_t>& out)
+{
+    const SpriteId* sprites = &chunk.sprites[0][0];
+    const std::size_t num_sprites = MapChunk::NUM_LAYERS * kChunkTiles;
+
+    std::size_t i = 0;
+    while (i < num_sprites) {
+        std::size_t run_end = i + 1;
+        while (run_end < num_sprites && sprites[run_end] == sprites[i]) {
+            ++run_end;
+        }
+        appendRun(run_end - i, sprites[i], out);
+        i = run_end;
+    }
+}
+
+bool decodeChunk(const uint8_t* data, std::size_t size, MapChunk& chunk)
+{
+    SpriteId* sprites = &chunk.sprites[0][0];
+    const std::size_t num_sprites = MapChunk::NUM_LAYERS * kChunkTiles;
+
+    std::size_t decoded = 0;
+    for (std::size_t pos = 0; pos + 2 * sizeof(uint16_t) <= size;
+            pos += 2 * sizeof(uint16_t)) {
+        uint16_t run[2];
+        std::memcpy(run, data + pos, sizeof(run));
+        if (run[0] > num_sprites - decoded) {
+            return false;
+        }
+        std::fill(sprites + decoded, sprites + decoded + run[0], run[1]);
+        decoded += run[0];
+    }
+    return decoded == num_sprites;
+}
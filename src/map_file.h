@@ -0,0 +1,45 @@
+#ifndef MAP_FILE_H_
+#define MAP_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "map_chunk.h"
+
+// On-disk map layout (host byte order, all sections 8-byte aligned):
+//   MapFileHeader
+//   tileset:    num_tileset x MapFileTile, entry 0 is unused
+//   wall bits:  num_rows x ceil(num_cols / 64) uint64_t, as kept by Map
+//   chunk table: one MapFileChunk per chunk, row-major
+//   chunk data: run-length encoded MapChunk sprites
+struct MapFileHeader {
+    char magic[8];
+    uint32_t num_rows;
+    uint32_t num_cols;
+    uint32_t chunk_size;
+    uint32_t num_tileset;
+    uint64_t tileset_offset;
+    uint64_t wall_bits_offset;
+    uint64_t chunk_table_offset;
+};
+
+// Source tile of a tileset sprite in the map sprite sheet
+struct MapFileTile {
+    uint16_t source_col;
+    uint16_t source_row;
+};
+
+struct MapFileChunk {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+extern const char kMapFileMagic[8];
+
+// Appends |chunk| to |out| as (count, sprite id) runs of uint16_t.
+void encodeChunk(const MapChunk& chunk, std::vector<uint8_t>& out);
+// Returns false if |data| is not a valid encoding of a whole chunk.
+bool decodeChunk(const uint8_t* data, std::size_t size, MapChunk& chunk);
+
+#endif /* MAP_FILE_H_ */
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "map_streamer.h"
+#include "trace.h"
+
+#if !defined(__SWITCH__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAP_STREAMER_USE_MMAP
+#endif
+
+// Read-only view of the map file. Memory-mapped where the platform has
+// mmap; otherwise chunks are read through stdio on demand, which keeps the
+// same bounded memory use at the cost of a copy.
+struct MapStreamer::File {
+    explicit File(const std::string& path);
+    ~File();
+
+    File(const File&)=delete;
+    File& operator=(const File&)=delete;
+
+    std::size_t size() const { return size_; }
+    // Returns a pointer to |size| bytes at |offset|, copying them into
+    // |scratch| first if the file is not mapped.
+    const uint8_t* data(uint64_t offset, std::size_t size,
+            std::vector<uint8_t>& scratch) const;
+
+private:
+    std::size_t size_;
+#ifdef MAP_STREAMER_USE_MMAP
+    int fd_;
+    const uint8_t* mapping_;
+#else
+    std::FILE* stream_;
+    mutable std::mutex mutex_;
+#endif
+};
+
+#ifdef MAP_STREAMER_USE_MMAP
+
+MapStreamer::File::File(const std::string& path) :
+    size_{0},
+    fd_{open(path.c_str(), O_RDONLY)},
+    mapping_{nullptr}
+{
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open map '" + path + "'!");
+    }
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        close(fd_);
+        throw std::runtime_error("Cannot stat map '" + path + "'!");
+    }
+    size_ = info.st_size;
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error("Cannot map '" + path + "'!");
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+}
+
+MapStreamer::File::~File()
+{
+    munmap(const_cast<uint8_t*>(mapping_), size_);
+    close(fd_);
+}
+
+const uint8_t* MapStreamer::File::data(uint64_t offset, std::size_t,
+        std::vector<uint8_t>&) const
+{
+    return mapping_ + offset;
+}
+
+#else
+
+MapStreamer::File::File(const std::string& path) :
+    size_{0},
+    stream_{std::fopen(path.c_str(), "rb")},
+    mutex_()
+{
+    if (stream_ == nullptr) {
+        throw std::runtime_error("Cannot open map '" + path + "'!");
+    }
+    std::fseek(stream_, 0, SEEK_END);
+    size_ = std::ftell(stream_);
+}
+
+MapStreamer::File::~File()
+{
+    std::fclose(stream_);
+}
+
+const uint8_t* MapStreamer::File::data(uint64_t offset, std::size_t size,
+        std::vector<uint8_t>& scratch) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    scratch.resize(size);
+    std::fseek(stream_, offset, SEEK_SET);
+    if (std::fread(scratch.data(), 1, size, stream_) != size) {
+        throw std::runtime_error("Cannot read map!");
+    }
+    return scratch.data();
+}
+
+#endif
+
+MapStreamer::MapStreamer(const std::string& file_path,
+        std::size_t memory_budget) :
+    file_{std::make_unique<File>(file_path)},
+    header_(),
+    chunk_rows_{0},
+    chunk_cols_{0},
+    chunk_table_(),
+    max_resident_{std::max<std::size_t>(1, memory_budget / sizeof(MapChunk))},
+    slots_(),
+    resident_(),
+    installing_(),
+    frame_{0},
+    mutex_(),
+    work_available_(),
+    requests_(),
+    decoded_(),
+    stopping_{false},
+    worker_()
+{
+    if (file_->size() < sizeof(header_)) {
+        throw std::runtime_error("Map '" + file_path + "' is truncated!");
+    }
+    read(0, sizeof(header_), &header_);
+    if (std::memcmp(header_.magic, kMapFileMagic, sizeof(kMapFileMagic)) != 0
+            || header_.chunk_size != kChunkSize) {
+        throw std::runtime_error("'" + file_path + "' is not a map file!");
+    }
+
+    chunk_rows_ = (header_.num_rows + kChunkSize - 1) / kChunkSize;
+    chunk_cols_ = (header_.num_cols + kChunkSize - 1) / kChunkSize;
+    const std::size_t num_chunks = chunk_rows_ * chunk_cols_;
+    chunk_table_.resize(num_chunks);
+    read(header_.chunk_table_offset,
+            num_chunks * sizeof(MapFileChunk), chunk_table_.data());
+    for (const auto& entry : chunk_table_) {
+        if (entry.offset + entry.size > file_->size()) {
+            throw std::runtime_error("Map '" + file_path + "' is truncated!");
+        }
+    }
+    slots_.resize(num_chunks);
+    resident_.reserve(max_resident_);
+
+    worker_ = std::thread(&MapStreamer::runWorker, this);
+}
+
+MapStreamer::~MapStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_one();
+    worker_.join();
+}
+
+const MapFileHeader& MapStreamer::getHeader() const
+{
+    return header_;
+}
+
+void MapStreamer::read(uint64_t offset, std::size_t size, void* dst) const
+{
+    if (offset + size > file_->size()) {
+        throw std::runtime_error("Map section out of range!");
+    }
+    std::vector<uint8_t> scratch;
+    std::memcpy(dst, file_->data(offset, size, scratch), size);
+}
+
+void MapStreamer::update(const ChunkRange& wanted)
+{
+    ++frame_;
+    bool has_work = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        installing_.swap(decoded_);
+        // Requests the view has moved away from go back to the pool; the
+        // ones still wanted are queued again below, nearest view first.
+        for (const auto index : requests_) {
+            slots_[index].pending = false;
+        }
+        requests_.clear();
+
+        for (auto row = wanted.first_row; row < wanted.end_row; ++row) {
+            for (auto col = wanted.first_col; col < wanted.end_col; ++col) {
+                Slot& slot = slots_[row * chunk_cols_ + col];
+                slot.last_used = frame_;
+                if (!slot.chunk && !slot.pending) {
+                    slot.pending = true;
+                    requests_.push_back(row * chunk_cols_ + col);
+                }
+            }
+        }
+        // The worker pops requests under the lock, so read them here
+        has_work = !requests_.empty();
+    }
+    if (has_work) {
+        work_available_.notify_one();
+    }
+
+    for (auto& decoded : installing_) {
+        Slot& slot = slots_[decoded.index];
+        slot.chunk = std::move(decoded.chunk);
+        slot.pending = false;
+        resident_.push_back(decoded.index);
+    }
+    installing_.clear();
+
+    evictOverBudget();
+}
+
+const MapChunk* MapStreamer::getChunk(units::Tile chunk_row,
+        units::Tile chunk_col) const
+{
+    return slots_[chunk_row * chunk_cols_ + chunk_col].chunk.get();
+}
+
+void MapStreamer::evictOverBudget()
+{
+    while (resident_.size() > max_resident_) {
+        auto lru = std::min_element(resident_.begin(), resident_.end(),
+                [this](std::size_t a, std::size_t b) {
+                    return slots_[a].last_used < slots_[b].last_used;
+                });
+        if (slots_[*lru].last_used == frame_) {
+            return;
+        }
+        slots_[*lru].chunk.reset();
+        *lru = resident_.back();
+        resident_.pop_back();
+    }
+}
+
+void MapStreamer::runWorker()
+{
+    trace::setThreadName("map streamer");
+    std::vector<uint8_t> scratch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_available_.wait(lock, [this] {
+            return stopping_ || !requests_.empty();
+        });
+        if (stopping_) {
+            return;
+        }
+        const std::size_t index = requests_.front();
+        requests_.pop_front();
+        lock.unlock();
+
+        TRACE_ZONE("MapStreamer decode");
+        const MapFileChunk& entry = chunk_table_[index];
+        auto chunk = std::make_unique<MapChunk>();
+        if (!decodeChunk(file_->data(entry.offset, entry.size, scratch),
+                    entry.size, *chunk)) {
+            // Draw a corrupt chunk as empty rather than stalling the game
+            std::memset(chunk.get(), 0, sizeof(MapChunk));
+        }
+
+        lock.lock();
+        decoded_.push_back(Decoded{index, std::move(chunk)});
+    }
+}
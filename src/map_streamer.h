@@ -0,0 +1,83 @@
+#ifndef MAP_STREAMER_H_
+#define MAP_STREAMER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "map_chunk.h"
+#include "map_file.h"
+
+// Keeps the chunks of a map file near the view resident. Chunks are decoded
+// on a background thread and evicted least recently used once the resident
+// set outgrows the memory budget. Only update() and getChunk() may be
+// called from the game thread; everything else is for load time.
+struct MapStreamer {
+    MapStreamer(const std::string& file_path, std::size_t memory_budget);
+    ~MapStreamer();
+
+    MapStreamer(const MapStreamer&)=delete;
+    MapStreamer& operator=(const MapStreamer&)=delete;
+
+    const MapFileHeader& getHeader() const;
+    // Copies |size| bytes at |offset| of the map file into |dst|
+    void read(uint64_t offset, std::size_t size, void* dst) const;
+
+    // Requests every chunk of |wanted| that is not resident yet, installs
+    // chunks decoded since the last call and evicts over budget. Chunks in
+    // |wanted| are never evicted, even if they alone exceed the budget.
+    void update(const ChunkRange& wanted);
+    // Returns nullptr if the chunk is not resident
+    const MapChunk* getChunk(units::Tile chunk_row,
+            units::Tile chunk_col) const;
+
+private:
+    struct File;
+    struct Slot {
+        Slot() :
+            chunk(),
+            last_used{0},
+            pending{false}
+        {}
+
+        std::unique_ptr<MapChunk> chunk;
+        uint64_t last_used;
+        bool pending;
+    };
+    struct Decoded {
+        std::size_t index;
+        std::unique_ptr<MapChunk> chunk;
+    };
+
+    void runWorker();
+    void evictOverBudget();
+
+    std::unique_ptr<File> file_;
+    MapFileHeader header_;
+    units::Tile chunk_rows_;
+    units::Tile chunk_cols_;
+    std::vector<MapFileChunk> chunk_table_;
+    std::size_t max_resident_;
+
+    // Game thread only
+    std::vector<Slot> slots_;
+    std::vector<std::size_t> resident_;
+    std::vector<Decoded> installing_;
+    uint64_t frame_;
+
+    // Shared with the worker, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::deque<std::size_t> requests_;
+    std::vector<Decoded> decoded_;
+    bool stopping_;
+
+    std::thread worker_;
+};
+
+#endif /* MAP_STREAMER_H_ */
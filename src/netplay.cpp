@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "netplay.h"
+
+namespace {
+
+const uint16_t kDefaultPort{7700};
+const units::Frame kDefaultInputDelay{2};
+
+} // anonymous namespace
+
+NetplayConfig::NetplayConfig() :
+    seed{1},
+    local_port{kDefaultPort},
+    remote_host("127.0.0.1"),
+    remote_port{kDefaultPort + 1},
+    local_player{0},
+    input_delay{kDefaultInputDelay},
+    loopback{false},
+    latency{0},
+    jitter{0},
+    loss{0.0}
+{}
+
+NetplayStats::NetplayStats() :
+    frames{0},
+    waits{0},
+    rollbacks{0},
+    resimulated{0},
+    longest_rollback{0},
+    worst_resimulation{0}
+{}
+
+void NetplayStats::addRollback(units::Frame num_frames,
+        std::chrono::duration<double, std::milli> elapsed)
+{
+    ++rollbacks;
+    resimulated += num_frames;
+    longest_rollback = std::max(longest_rollback, num_frames);
+    worst_resimulation = std::max(worst_resimulation, elapsed);
+}
+
+void NetplayStats::report(std::ostream& out) const
+{
+    // Formatted apart so the precision does not stick to |out|
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(3)
+        << "netplay: " << frames << " frames, " << waits << " waits, "
+        << rollbacks << " rollbacks resimulating " << resimulated
+        << " frames (at most " << longest_rollback << " at once), "
+        << "worst resimulation " << worst_resimulation.count() << " ms\n";
+    out << line.str();
+}
+
+LoopbackPeer::LoopbackPeer(uint16_t local_port, uint16_t remote_port,
+        std::size_t player, const NetplayConfig& config, uint64_t seed) :
+    link_(local_port, "127.0.0.1", remote_port),
+    conditioner_(link_, config.latency, config.jitter, config.loss,
+            Rng(seed).split(2).next()),
+    session_(conditioner_, player, config.input_delay),
+    bot_(Rng(seed).split(3))
+{}
+
+void LoopbackPeer::tick(std::chrono::milliseconds now)
+{
+    conditioner_.setNow(now);
+    session_.poll();
+    if (!session_.shouldWait()) {
+        session_.addLocalInput(bot_.next());
+        session_.simulated(session_.getFrame());
+    }
+    session_.flush();
+}
+
+NetplayConnection::NetplayConnection(const NetplayConfig& config) :
+    link_(config.local_port,
+            config.loopback ? "127.0.0.1" : config.remote_host,
+            config.loopback ? config.local_port + 1 : config.remote_port),
+    conditioner_(link_, config.latency, config.jitter, config.loss,
+            Rng(config.seed).split(config.local_player).next()),
+    session_(conditioner_, config.local_player, config.input_delay),
+    peer_()
+{
+    if (config.loopback) {
+        peer_ = std::make_unique<LoopbackPeer>(config.local_port + 1,
+                config.local_port, 1 - config.local_player, config,
+                config.seed);
+    }
+}
+
+NetplayConnection::~NetplayConnection() {}
+
+void NetplayConnection::tick(std::chrono::milliseconds now)
+{
+    conditioner_.setNow(now);
+    if (peer_) {
+        peer_->tick(now);
+    }
+}
+
+RollbackSession& NetplayConnection::getSession()
+{
+    return session_;
+}
@@ -0,0 +1,94 @@
+#ifndef NETPLAY_H_
+#define NETPLAY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include "input.h"
+#include "link_conditioner.h"
+#include "rng.h"
+#include "rollback_session.h"
+#include "udp_link.h"
+#include "units.h"
+
+// How to reach the other player of a two-player rollback session (see
+// Game(const NetplayConfig&)). Both peers must agree on the seed and the
+// input delay.
+struct NetplayConfig {
+    NetplayConfig();
+
+    uint64_t seed;
+    uint16_t local_port;
+    std::string remote_host;
+    uint16_t remote_port;
+    // 0 or 1; player 0 starts where a single player would
+    std::size_t local_player;
+    units::Frame input_delay;
+    // Plays against a LoopbackPeer on the next port instead of remote_host
+    bool loopback;
+    // Network conditions simulated on top of the real ones, on receipt
+    std::chrono::milliseconds latency;
+    std::chrono::milliseconds jitter;
+    double loss;
+};
+
+// What rolling back cost over a session
+struct NetplayStats {
+    NetplayStats();
+
+    // Adds one resimulation of |num_frames| that took |elapsed|
+    void addRollback(units::Frame num_frames,
+            std::chrono::duration<double, std::milli> elapsed);
+    void report(std::ostream& out) const;
+
+    units::Frame frames;
+    units::Frame waits;
+    std::size_t rollbacks;
+    units::Frame resimulated;
+    units::Frame longest_rollback;
+    std::chrono::duration<double, std::milli> worst_resimulation;
+};
+
+// In-process stand-in for the other player, to try netplay on one machine.
+// It speaks the netplay protocol over UDP on 127.0.0.1, from |local_port|
+// to |remote_port|, and plays random input. It keeps no world, so it
+// never needs to roll back.
+struct LoopbackPeer {
+    LoopbackPeer(uint16_t local_port, uint16_t remote_port,
+            std::size_t player, const NetplayConfig& config, uint64_t seed);
+    LoopbackPeer(const LoopbackPeer&)=delete;
+    LoopbackPeer& operator=(const LoopbackPeer&)=delete;
+
+    // One frame of the peer's loop at |now| on the simulated network clock
+    void tick(std::chrono::milliseconds now);
+
+private:
+    UdpLink link_;
+    LinkConditioner conditioner_;
+    RollbackSession session_;
+    InputBot bot_;
+};
+
+// The link to the other player as set up by a NetplayConfig: UDP, the
+// network simulator on top, and for loopback sessions the peer itself
+struct NetplayConnection {
+    NetplayConnection(const NetplayConfig& config);
+    NetplayConnection(const NetplayConnection&)=delete;
+    NetplayConnection& operator=(const NetplayConnection&)=delete;
+    ~NetplayConnection();
+
+    // Moves the simulated network clock, and the loopback peer with it
+    void tick(std::chrono::milliseconds now);
+    RollbackSession& getSession();
+
+private:
+    UdpLink link_;
+    LinkConditioner conditioner_;
+    RollbackSession session_;
+    std::unique_ptr<LoopbackPeer> peer_;
+};
+
+#endif /* NETPLAY_H_ */
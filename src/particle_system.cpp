@@ -1,24 +1,35 @@
 #include "particle_system.h"
-#include "particle.h"
+#include "trace.h"
 
-void ParticleSystem::addNewParticle(std::shared_ptr<Particle> particle) {
-    particles_.insert(particle);
+ParticleSystem::ParticleSystem(Graphics& graphics) :
+    head_bump_particles_(graphics)
+{}
+
+void ParticleSystem::addHeadBumpParticle(Vector<units::Game> center_pos,
+        Rng& random) {
+    head_bump_particles_.spawn(center_pos, random);
 }
 
-bool ParticleSystem::update(const std::chrono::milliseconds elapsed_time) {
-    for (auto it = particles_.begin(); it != particles_.end(); ) {
-        if ((*it)->update(elapsed_time)) {
-            ++it;
-        } else {
-            particles_.erase(it++);
-        }
+std::size_t ParticleSystem::size() const {
+    return head_bump_particles_.size();
+}
 
-    }
+bool ParticleSystem::update(const std::chrono::milliseconds elapsed_time,
+        JobSystem& jobs) {
+    TRACE_ZONE("ParticleSystem::update");
+    head_bump_particles_.update(elapsed_time, jobs);
     return true;
 }
 
 void ParticleSystem::draw(Graphics& graphics) const {
-    for (auto& particle: particles_) {
-        particle->draw(graphics);
-    }
+    TRACE_ZONE("ParticleSystem::draw");
+    head_bump_particles_.draw(graphics);
+}
+
+void ParticleSystem::save(StateWriter& writer) const {
+    head_bump_particles_.save(writer);
+}
+
+void ParticleSystem::restore(StateReader& reader) {
+    head_bump_particles_.restore(reader);
 }
@@ -2,25 +2,37 @@
 #define PARTICLE_SYSTEM_H_
 
 #include <chrono>
-#include <memory>
-#include <set>
+#include <cstddef>
 
+#include "head_bump_particle.h"
 #include "units.h"
+#include "vector.h"
 
 struct Graphics;
-struct Particle;
+struct JobSystem;
+struct Rng;
+struct StateReader;
+struct StateWriter;
 
+// Owns one structure-of-arrays pool per particle type.
 struct ParticleSystem {
-    ParticleSystem() :
-        particles_{}
-    {}
-    void addNewParticle(std::shared_ptr<Particle> particle);
-    bool update(const std::chrono::milliseconds elapsed_time);
+    ParticleSystem(Graphics& graphics);
+
+    // Spark directions and distances are drawn from |random|
+    void addHeadBumpParticle(Vector<units::Game> center_pos, Rng& random);
+    std::size_t size() const;
+
+    // Pools are integrated across |jobs|; dead particles are removed on the
+    // calling thread.
+    bool update(const std::chrono::milliseconds elapsed_time, JobSystem& jobs);
     void draw(Graphics& graphics) const;
 
+    // Savestate of every live particle
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
+
 private:
-    typedef std::set<std::shared_ptr<Particle> > ParticleSet;
-    ParticleSet particles_;
+    HeadBumpParticlePool head_bump_particles_;
 };
 
 #endif /* PARTICLE_SYSTEM_H_ */
@@ -3,10 +3,12 @@
 
 #include "graphics.h"
 #include "particle_system.h"
+#include "rng.h"
 
 struct ParticleTools {
     ParticleSystem& system;
     Graphics& graphics;
+    Rng& random;
 };
 
 #endif /* PARTICLE_TOOLS_H_ */
@@ -2,14 +2,14 @@
 #include <cmath>
 
 #include "player.h"
-#include "animated_sprite.h"
-#include "number_sprite.h"
 #include "graphics.h"
 #include "game.h"
-#include "head_bump_particle.h"
 #include "map.h"
 #include "particle_tools.h"
 #include "rectangle.h"
+#include "savestate.h"
+#include "sweep.h"
+#include "trace.h"
 
 // Walk Motion
 const units::Acceleration kWalkingAcceleration{0.00083007812};
@@ -60,23 +60,68 @@ const std::chrono::milliseconds kInvincibleTime{3000};
 
 namespace {
 
-struct CollisionInfo {
-    bool collided;
-    units::Tile row;
-    units::Tile col;
-};
-CollisionInfo getWallCollisionInfo(const Map& map, const Rectangle& rect) {
-    CollisionInfo info{false, 0, 0};
-    std::vector<Map::CollisionTile> tiles(map.getCollidingTiles(rect));
-    for (auto &tile : tiles) {
-        if (tile.tile_type == Map::TileType::WALL) {
-            info = {true, tile.row, tile.col};
+// Tile of the sprite sheet that shows the player in the given state
+constexpr Vector<units::Tile> getFrame(MotionType motion_type,
+        HorizontalFacing horizontal_facing,
+        VerticalFacing vertical_facing,
+        StrideType stride_type)
+{
+    units::Tile tile_x{0};
+    switch (motion_type) {
+    case MotionType::WALKING:
+        tile_x = kWalkFrame;
+
+        switch (stride_type) {
+        case StrideType::MIDDLE:
+            break;
+        case StrideType::LEFT:
+            tile_x += kLeftFrameOffset;
+            break;
+        case StrideType::RIGHT:
+            tile_x += kRightFrameOffset;
+            break;
+        default:
             break;
         }
+
+        break;
+    case MotionType::STANDING:
+        tile_x = kStandFrame;
+        break;
+    case MotionType::INTERACTING:
+        tile_x = kBackFrame;
+        break;
+    case MotionType::JUMPING:
+        tile_x = kJumpFrame;
+        break;
+    case MotionType::FALLING:
+        tile_x = kFallFrame;
+        break;
+    case MotionType::LAST:
+        break;
     }
-    return info;
+    switch (vertical_facing) {
+    case VerticalFacing::HORIZONTAL:
+        break;
+    case VerticalFacing::UP:
+        tile_x += kUpFrameOffset;
+        break;
+    case VerticalFacing::DOWN:
+        tile_x = kDownFrame;
+        break;
+    default:
+        break;
+    }
+
+    const units::Tile tile_y = (horizontal_facing == HorizontalFacing::LEFT)
+        ? 2 * kCharacterFrame
+        : 1 + 2 * kCharacterFrame;
+    return Vector<units::Tile>{tile_x, tile_y};
 }
 
+constexpr auto kFrames = makeEnumTable<Vector<units::Tile>,
+      MotionType, HorizontalFacing, VerticalFacing, StrideType>(&getFrame);
+
 } // anonymous namespace
 
 Player::Player(Graphics& graphics, Vector<units::Game> pos) :
@@ -91,7 +136,7 @@ Player::Player(Graphics& graphics, Vector<units::Game> pos) :
     health_(graphics),
     invincible_timer_{kInvincibleTime},
     damage_text_(std::make_shared<DamageText>()),
-    walking_animation_(),
+    walking_animation_(Animation::start(ClipId::PLAYER_WALK)),
     polar_star_(graphics),
     sprites_()
 {
@@ -104,10 +149,8 @@ void Player::update(const std::chrono::milliseconds elapsed_time,
                     const Map& map,
                     ParticleTools& particle_tools)
 {
-    sprites_[getSpriteState()]->update();
-
+    TRACE_ZONE("Player::update");
     health_.update();
-    walking_animation_.update();
 
     polar_star_.updateProjectiles(elapsed_time, map);
 
@@ -125,7 +168,7 @@ void Player::draw(Graphics& graphics) const
                 is_gun_up(),
                 pos_
                 );
-        sprites_.at(getSpriteState())->draw(graphics, pos_);
+        graphics.getSpriteRegistry().draw(getSprite(), pos_);
     }
 }
 
@@ -139,7 +182,7 @@ void Player::drawHUD(Graphics& graphics) const
 void Player::startMovingLeft()
 {
     if (is_on_ground() && acceleration_x_direction_ == 0) {
-        walking_animation_.reset();
+        walking_animation_.restart();
     }
     horizontal_facing_ = HorizontalFacing::LEFT;
     acceleration_x_direction_ = -1;
@@ -149,7 +192,7 @@ void Player::startMovingLeft()
 void Player::startMovingRight()
 {
     if (is_on_ground() && acceleration_x_direction_ == 0) {
-        walking_animation_.reset();
+        walking_animation_.restart();
     }
     horizontal_facing_ = HorizontalFacing::RIGHT;
     acceleration_x_direction_ = 1;
@@ -238,102 +281,61 @@ const std::shared_ptr<DamageText> Player::getDamageText() const
     return damage_text_;
 }
 
-std::vector<std::shared_ptr<GenericProjectile> > Player::getProjectiles()
+ProjectileView<PolarStar::Projectile> Player::getProjectiles()
 {
     return polar_star_.getProjectiles();
 }
 
-bool Player::is_gun_up() const
-{
-    return (getMotionType() == MotionType::WALKING)
-        && (walking_animation_.stride() != StrideType::MIDDLE);
-}
-
-units::Tile Player::getFrameY(const SpriteState& s) const
-{
-    units::Tile tile_y = (s.horizontal_facing == HorizontalFacing::LEFT)
-        ? 2 * kCharacterFrame
-        : 1 + 2 * kCharacterFrame;
-    return tile_y;
-}
-
-units::Tile Player::getFrameX(const SpriteState& s) const
-{
-    units::Tile tile_x{0};
-    switch (s.motion_type) {
-    case MotionType::WALKING:
-        tile_x = kWalkFrame;
-
-        switch (s.stride_type) {
-        case StrideType::MIDDLE:
-            break;
-        case StrideType::LEFT:
-            tile_x += kLeftFrameOffset;
-            break;
-        case StrideType::RIGHT:
-            tile_x += kRightFrameOffset;
-            break;
-        default:
-            break;
-        }
-
-        break;
-    case MotionType::STANDING:
-        tile_x = kStandFrame;
-        break;
-    case MotionType::INTERACTING:
-        tile_x = kBackFrame;
-        break;
-    case MotionType::JUMPING:
-        tile_x = kJumpFrame;
-        break;
-    case MotionType::FALLING:
-        tile_x = kFallFrame;
-        break;
-    case MotionType::LAST:
-        break;
-    }
-    switch (s.vertical_facing) {
-    case VerticalFacing::HORIZONTAL:
-        break;
-    case VerticalFacing::UP:
-        tile_x += kUpFrameOffset;
-        break;
-    case VerticalFacing::DOWN:
-        tile_x = kDownFrame;
-        break;
-    default:
-        break;
-    }
-
-    return tile_x;
+void Player::save(StateWriter& writer) const
+{
+    writer.write(pos_);
+    writer.write(velocity_);
+    writer.write(acceleration_x_direction_);
+    writer.write(horizontal_facing_);
+    writer.write(intended_vertical_facing_);
+    writer.write(is_on_ground_);
+    writer.write(is_jump_active_);
+    writer.write(is_interacting_);
+    health_.save(writer);
+    invincible_timer_.save(writer);
+    damage_text_->save(writer);
+    writer.write(walking_animation_.clip);
+    writer.write(walking_animation_.start_time);
+    polar_star_.save(writer);
+}
+
+void Player::restore(StateReader& reader)
+{
+    reader.read(pos_);
+    reader.read(velocity_);
+    reader.read(acceleration_x_direction_);
+    reader.read(horizontal_facing_);
+    reader.read(intended_vertical_facing_);
+    reader.read(is_on_ground_);
+    reader.read(is_jump_active_);
+    reader.read(is_interacting_);
+    health_.restore(reader);
+    invincible_timer_.restore(reader);
+    damage_text_->restore(reader);
+    reader.read(walking_animation_.clip);
+    reader.read(walking_animation_.start_time);
+    polar_star_.restore(reader);
 }
 
-void Player::initializeSprite(Graphics& graphics,
-        const SpriteState& sprite_state)
+bool Player::is_gun_up() const
 {
-    units::Tile tile_y = getFrameY(sprite_state);
-    units::Tile tile_x = getFrameX(sprite_state);
-
-    sprites_[sprite_state] = std::make_unique<Sprite>(
-                graphics,
-                kPlayerSpriteFilePath,
-                units::tileToPixel(tile_x), units::tileToPixel(tile_y),
-                units::tileToPixel(1), units::tileToPixel(1)
-    );
+    return (getMotionType() == MotionType::WALKING)
+        && (stride() != StrideType::MIDDLE);
 }
 
 void Player::initializeSprites(Graphics& graphics)
 {
-    for (auto mt = MotionType::FIRST; mt != MotionType::LAST; ++mt) {
-        for (auto hf = HorizontalFacing::FIRST; hf != HorizontalFacing::LAST; ++hf) {
-            for (auto vf = VerticalFacing::FIRST; vf != VerticalFacing::LAST; ++vf) {
-                for (auto st = StrideType::FIRST; st != StrideType::LAST; ++st) {
-                    auto sprite = SpriteState(mt, hf, vf, st);
-                    initializeSprite(graphics, sprite);
-                }
-            }
-        }
+    SpriteRegistry& sprites = graphics.getSpriteRegistry();
+    for (std::size_t i = 0; i < kFrames.size(); ++i) {
+        sprites_.values[i] = sprites.add(kPlayerSpriteFilePath,
+                units::tileToPixel(kFrames.values[i].x),
+                units::tileToPixel(kFrames.values[i].y),
+                units::tileToPixel(1), units::tileToPixel(1));
     }
 }
 
@@ -368,23 +370,13 @@ VerticalFacing Player::vertical_facing() const
     }
 }
 
-auto Player::SpriteState::rank() const
-{
-    return std::tie(motion_type, horizontal_facing, vertical_facing, stride_type);
-}
-
-bool operator<(const Player::SpriteState& a, const Player::SpriteState& b)
-{
-    return a.rank() < b.rank();
-}
-
-const Player::SpriteState Player::getSpriteState() const
+SpriteRegistry::Id Player::getSprite() const
 {
-    return SpriteState(
+    return sprites_(
             getMotionType(),
             horizontal_facing_,
             vertical_facing(),
-            walking_animation_.stride()
+            stride()
             );
 }
 
@@ -436,6 +428,7 @@ void Player::updateX(const std::chrono::milliseconds elapsed_time,
                      const Map& map,
                      ParticleTools&)
 {
+    TRACE_ZONE("Player::updateX");
     // Update velocity
     units::Acceleration acceleration_x{0.0};
     if (acceleration_x_direction_ < 0) {
@@ -464,33 +457,35 @@ void Player::updateX(const std::chrono::milliseconds elapsed_time,
 
     if (delta > 0.0) {
         // Check collision in the direction of delta
-        CollisionInfo info = getWallCollisionInfo(map, rightCollision(delta));
+        const TileHit info = sweepRectangle(map, rightCollision(0),
+                Vector<units::Game>{delta, 0.0});
         // React to collision
-        if (info.collided) {
+        if (info.hit) {
             pos_.x = units::tileToGame(info.col) - kCollisionX.getRight();
             velocity_.x = 0.0;
         } else {
             pos_.x += delta;
         }
         // Check collision in the direction opposite to delta
-        info = getWallCollisionInfo(map, leftCollision(0));
-        if (info.collided) {
-            pos_.x = units::tileToGame(info.col) + kCollisionX.getRight();
+        const auto opposite = map.getWallCollisionInfo(leftCollision(0));
+        if (opposite.collided) {
+            pos_.x = units::tileToGame(opposite.col) + kCollisionX.getRight();
         }
     } else {
         // Check collision in the direction of delta
-        CollisionInfo info = getWallCollisionInfo(map, leftCollision(delta));
+        const TileHit info = sweepRectangle(map, leftCollision(0),
+                Vector<units::Game>{delta, 0.0});
         // React to collision
-        if (info.collided) {
+        if (info.hit) {
             pos_.x = units::tileToGame(info.col) + kCollisionX.getRight();
             velocity_.x = 0.0;
         } else {
             pos_.x += delta;
         }
         // Check collision in the direction opposite to delta
-        info = getWallCollisionInfo(map, rightCollision(0));
-        if (info.collided) {
-            pos_.x = units::tileToGame(info.col) - kCollisionX.getRight();
+        const auto opposite = map.getWallCollisionInfo(rightCollision(0));
+        if (opposite.collided) {
+            pos_.x = units::tileToGame(opposite.col) - kCollisionX.getRight();
         }
     }
 }
@@ -501,15 +496,14 @@ void Player::createHeadBumpParticle(ParticleTools& particle_tools)
         pos_.x,
         pos_.y + kCollisionYTop
     };
-    particle_tools.system.addNewParticle(
-            std::make_shared<HeadBumpParticle>(particle_tools.graphics, bump_pos));
-
+    particle_tools.system.addHeadBumpParticle(bump_pos, particle_tools.random);
 }
 
 void Player::updateY(const std::chrono::milliseconds elapsed_time,
                      const Map& map,
                      ParticleTools& particle_tools)
 {
+    TRACE_ZONE("Player::updateY");
     // Update velocity
     const units::Acceleration gravity = is_jump_active_ && velocity_.y < 0
         ? kJumpGravity
@@ -520,9 +514,10 @@ void Player::updateY(const std::chrono::milliseconds elapsed_time,
     const units::Game delta = velocity_.y * elapsed_time.count();
     if (delta > 0.0) {
         // Check collision in the direction of delta
-        CollisionInfo info = getWallCollisionInfo(map, bottomCollision(delta));
+        const TileHit info = sweepRectangle(map, bottomCollision(0),
+                Vector<units::Game>{0.0, delta});
         // React to collision
-        if (info.collided) {
+        if (info.hit) {
             pos_.y = units::tileToGame(info.row) - kCollisionYBottom;
             velocity_.y = 0.0;
             is_on_ground_ = true;
@@ -531,16 +526,17 @@ void Player::updateY(const std::chrono::milliseconds elapsed_time,
             is_on_ground_ = false;
         }
         // Check collision in the direction opposite to delta
-        info = getWallCollisionInfo(map, topCollision(0));
-        if (info.collided) {
-            pos_.y = units::tileToGame(info.row) + kCollisionYHeight;
+        const auto opposite = map.getWallCollisionInfo(topCollision(0));
+        if (opposite.collided) {
+            pos_.y = units::tileToGame(opposite.row) + kCollisionYHeight;
             createHeadBumpParticle(particle_tools);
         }
     } else {
         // Check collision in the direction of delta
-        CollisionInfo info = getWallCollisionInfo(map, topCollision(delta));
+        const TileHit info = sweepRectangle(map, topCollision(0),
+                Vector<units::Game>{0.0, delta});
         // React to collision
-        if (info.collided) {
+        if (info.hit) {
             pos_.y = units::tileToGame(info.row) + kCollisionYHeight;
             createHeadBumpParticle(particle_tools);
             velocity_.y = 0.0;
@@ -549,9 +545,9 @@ void Player::updateY(const std::chrono::milliseconds elapsed_time,
             is_on_ground_ = false;
         }
         // Check collision in the direction opposite to delta
-        info = getWallCollisionInfo(map, bottomCollision(0));
-        if (info.collided) {
-            pos_.y = units::tileToGame(info.row) - kCollisionYBottom;
+        const auto opposite = map.getWallCollisionInfo(bottomCollision(0));
+        if (opposite.collided) {
+            pos_.y = units::tileToGame(opposite.row) - kCollisionYBottom;
             is_on_ground_ = true;
         }
     }
@@ -2,14 +2,17 @@
 #define PLAYER_H_
 
 #include <chrono>
+#include "animation.h"
 #include "damageable.h"
 #include "damage_text.h"
-#include "number_sprite.h"
+#include "enum_table.h"
 #include "motion_type.h"
 #include "polar_star.h"
 #include "sprite.h"
+#include "sprite_registry.h"
 #include "sprite_state.h"
 #include "stride_type.h"
+#include "text_renderer.h"
 #include "timer.h"
 #include "units.h"
 #include "varying_width_sprite.h"
@@ -17,10 +20,11 @@
 
 struct Graphics;
 struct Map;
-struct NumberSprite;
 struct Projectile;
 struct Rectangle;
 struct ParticleTools;
+struct StateReader;
+struct StateWriter;
 
 struct Player : public Damageable {
    Player(Graphics& graphics, Vector<units::Game> pos);
@@ -50,49 +54,19 @@ struct Player : public Damageable {
    const Rectangle getDamageRectangle() const;
    const Vector<units::Game> getCenterPos() const override;
    const std::shared_ptr<DamageText> getDamageText() const override;
-   std::vector<std::shared_ptr<GenericProjectile> > getProjectiles();
+   ProjectileView<PolarStar::Projectile> getProjectiles();
+
+   // Savestate of the player's physics, health, timers and projectiles
+   void save(StateWriter& writer) const;
+   void restore(StateReader& reader);
 
 private:
    bool is_gun_up() const;
 
-   struct SpriteState {
-       SpriteState(MotionType motion_type=MotionType::STANDING,
-               HorizontalFacing horizontal_facing=HorizontalFacing::LEFT,
-               VerticalFacing vertical_facing=VerticalFacing::HORIZONTAL,
-               StrideType stride_type=StrideType::MIDDLE
-               ) :
-           motion_type{motion_type},
-           horizontal_facing{horizontal_facing},
-           vertical_facing{vertical_facing},
-           stride_type{stride_type}
-       {}
-
-       auto rank() const;
-
-       MotionType motion_type;
-       HorizontalFacing horizontal_facing;
-       VerticalFacing vertical_facing;
-       StrideType stride_type;
-   };
-   friend bool operator<(const SpriteState& a, const SpriteState& b);
-
-   struct WalkingAnimation {
-       WalkingAnimation();
-
-       StrideType stride() const;
-       void update();
-       void reset();
-   private:
-       Timer frame_timer_;
-       int current_index_;
-       bool forward_;
-   };
-   units::Tile getFrameX(const SpriteState&) const;
-   units::Tile getFrameY(const SpriteState&) const;
-
+   // Stride of the walk cycle at the current time
+   StrideType stride() const;
    void initializeSprites(Graphics& graphics);
-   void initializeSprite(Graphics& graphics, const SpriteState& sprite_state);
-   const SpriteState getSpriteState() const;
+   SpriteRegistry::Id getSprite() const;
 
    struct Health {
        Health(Graphics& graphics);
@@ -100,6 +74,10 @@ private:
        void draw(Graphics& graphics) const;
        // returns true if we have died
        bool takeDamage(units::HP damage);
+
+       void save(StateWriter& writer) const;
+       // Also brings the bars and the number in line with the health
+       void restore(StateReader& reader);
    private:
        units::Game fillOffset(units::HP health) const;
        units::HP damage_;
@@ -110,6 +88,7 @@ private:
        Sprite health_bar_sprite_;
        VaryingWidthSprite health_fill_bar_sprite_;
        VaryingWidthSprite damage_fill_sprite_;
+       TextLabel health_number_;
    };
 
    const Rectangle leftCollision(units::Game delta) const;
@@ -142,10 +121,11 @@ private:
    Timer invincible_timer_;
    std::shared_ptr<DamageText> damage_text_;
 
-   WalkingAnimation walking_animation_;
+   Animation walking_animation_;
    PolarStar polar_star_;
 
-   std::map<SpriteState, std::unique_ptr<Sprite> > sprites_;
+   EnumTable<SpriteRegistry::Id,
+       MotionType, HorizontalFacing, VerticalFacing, StrideType> sprites_;
 };
 
 #endif /* SRC/PLAYER_H_ */
@@ -1,4 +1,5 @@
 #include "player.h"
+#include "savestate.h"
 
 const std::string kHealthSpriteFilePath{"TextBox"};
 // HUD constants
@@ -32,7 +33,7 @@ const Vector<units::Game> kHealthNumberPos{
     units::tileToGame(3) / 2,
     units::tileToGame(2)
 };
-const int kHealthNumDigits = 2;
+const std::size_t kHealthNumDigits = 2;
 
 const std::chrono::milliseconds kDamageDelay{1500};
 
@@ -64,8 +65,12 @@ Player::Health::Health(Graphics& graphics) :
             units::gameToPixel(kDamageHealthSourceY),
             units::gameToPixel(0),
             units::gameToPixel(kDamageHealthHeight)
-            )
-{}
+            ),
+    health_number_(TextRenderer::Font::WHITE)
+{
+    health_number_.setNumber(current_health_,
+            TextLabel::Sign::NONE, kHealthNumDigits);
+}
 
 void Player::Health::update()
 {
@@ -73,6 +78,8 @@ void Player::Health::update()
         current_health_ -= damage_;
         damage_ = 0;
     }
+    health_number_.setNumber(current_health_,
+            TextLabel::Sign::NONE, kHealthNumDigits);
 }
 
 void Player::Health::draw(Graphics& graphics) const
@@ -88,8 +95,7 @@ void Player::Health::draw(Graphics& graphics) const
         damage_fill_sprite_.draw(graphics, pos);
     }
 
-    auto s = NumberSprite::HUDNumber(graphics, current_health_, kHealthNumDigits);
-    s.draw(graphics, kHealthBarPos);
+    health_number_.draw(graphics, kHealthBarPos);
 }
 
 bool Player::Health::takeDamage(units::HP damage)
@@ -104,6 +110,28 @@ bool Player::Health::takeDamage(units::HP damage)
     return current_health_ <= 0;
 }
 
+void Player::Health::save(StateWriter& writer) const
+{
+    writer.write(damage_);
+    damage_timer_.save(writer);
+    writer.write(max_health_);
+    writer.write(current_health_);
+}
+
+void Player::Health::restore(StateReader& reader)
+{
+    reader.read(damage_);
+    damage_timer_.restore(reader);
+    reader.read(max_health_);
+    reader.read(current_health_);
+
+    const auto offset = fillOffset(current_health_ - damage_);
+    health_fill_bar_sprite_.set_width(units::gameToPixel(offset));
+    damage_fill_sprite_.set_width(units::gameToPixel(fillOffset(damage_)));
+    health_number_.setNumber(current_health_,
+            TextLabel::Sign::NONE, kHealthNumDigits);
+}
+
 units::Game Player::Health::fillOffset(units::HP health) const
 {
     // TODO: fix drawing with negative health
@@ -1,13 +1,14 @@
 #include <string>
+#include "graphics.h"
 #include "map.h"
 #include "polar_star.h"
-#include "sprite.h"
+#include "sweep.h"
 
 const std::string kArmsSpritePath{"Arms"};
 const int kPolarStarIndex{2};
-const units::Game kGunWidth{3 * units::kHalfTile};
-const units::Game kGunHeight{2 * units::kHalfTile};
-const units::Game kGunBob{units::Game(2)};
+constexpr units::Game kGunWidth{3 * units::kHalfTile};
+constexpr units::Game kGunHeight{2 * units::kHalfTile};
+constexpr units::Game kGunBob{units::Game(2)};
 
 const units::Tile kHorizontalOffset{0};
 const units::Tile kUpOffset{2};
@@ -17,17 +18,17 @@ const units::Tile kLeftOffset{0};
 const units::Tile kRightOffset{1};
 
 // Nozzle Offsets
-const units::Game kNozzleHorizontalY{23};
-const units::Game kNozzleHorizontalLeftX{10};
-const units::Game kNozzleHorizontalRightX{38};
+constexpr units::Game kNozzleHorizontalY{23};
+constexpr units::Game kNozzleHorizontalLeftX{10};
+constexpr units::Game kNozzleHorizontalRightX{38};
 
-const units::Game kNozzleUpY{4};
-const units::Game kNozzleUpLeftX{27};
-const units::Game kNozzleUpRightX{21};
+constexpr units::Game kNozzleUpY{4};
+constexpr units::Game kNozzleUpLeftX{27};
+constexpr units::Game kNozzleUpRightX{21};
 
-const units::Game kNozzleDownY{28};
-const units::Game kNozzleDownLeftX{29};
-const units::Game kNozzleDownRightX{19};
+constexpr units::Game kNozzleDownY{28};
+constexpr units::Game kNozzleDownLeftX{29};
+constexpr units::Game kNozzleDownRightX{19};
 
 // Projectile Sprite
 const units::Tile kProjectileSourceY{2};
@@ -41,12 +42,111 @@ const units::Velocity kProjectileSpeed{0.6};
 const units::Game kProjectileMaxOffset{7 * units::kHalfTile};
 const units::Game kProjectileWidth{4.0};
 
+namespace {
+
+// Row of the arms sheet showing the gun pointing each way
+constexpr units::Tile getGunSourceRow(HorizontalFacing hfacing,
+        VerticalFacing vfacing)
+{
+    units::Tile tile_y = (hfacing == HorizontalFacing::LEFT)
+        ? kLeftOffset
+        : kRightOffset;
+    switch (vfacing) {
+        case VerticalFacing::HORIZONTAL:
+            tile_y += kHorizontalOffset;
+            break;
+        case VerticalFacing::UP:
+            tile_y += kUpOffset;
+            break;
+        case VerticalFacing::DOWN:
+            tile_y += kDownOffset;
+            break;
+        case VerticalFacing::LAST:
+            break;
+    }
+    return tile_y;
+}
+
+// Position of the gun relative to the player, before the walking bob
+constexpr Vector<units::Game> getGunOffset(HorizontalFacing hfacing,
+        VerticalFacing vfacing)
+{
+    Vector<units::Game> offset{0, 0};
+    if (hfacing == HorizontalFacing::LEFT) {
+        offset.x = -units::kHalfTile;
+    }
+    switch (vfacing) {
+        case VerticalFacing::UP:
+            offset.y = -units::kHalfTile / 2;
+            break;
+        case VerticalFacing::DOWN:
+            offset.y = units::kHalfTile / 2;
+            break;
+        case VerticalFacing::HORIZONTAL:
+        case VerticalFacing::LAST:
+            break;
+    }
+    return offset;
+}
+
+// Position of the nozzle relative to the top left corner of the gun sprite
+constexpr Vector<units::Game> getNozzleOffset(HorizontalFacing hfacing,
+        VerticalFacing vfacing)
+{
+    const bool left = (hfacing == HorizontalFacing::LEFT);
+    switch (vfacing) {
+        case VerticalFacing::HORIZONTAL:
+            return Vector<units::Game>{
+                left ? kNozzleHorizontalLeftX : kNozzleHorizontalRightX,
+                kNozzleHorizontalY};
+        case VerticalFacing::UP:
+            return Vector<units::Game>{
+                left ? kNozzleUpLeftX : kNozzleUpRightX,
+                kNozzleUpY};
+        case VerticalFacing::DOWN:
+            return Vector<units::Game>{
+                left ? kNozzleDownLeftX : kNozzleDownRightX,
+                kNozzleDownY};
+        case VerticalFacing::LAST:
+            break;
+    }
+    return Vector<units::Game>{0, 0};
+}
+
+// Unit vector along which a projectile fired each way travels
+constexpr Vector<units::Game> getProjectileDirection(HorizontalFacing hfacing,
+        VerticalFacing vfacing)
+{
+    switch (vfacing) {
+        case VerticalFacing::HORIZONTAL:
+            return Vector<units::Game>{
+                (hfacing == HorizontalFacing::LEFT) ? -1.0 : 1.0, 0};
+        case VerticalFacing::UP:
+            return Vector<units::Game>{0, -1.0};
+        case VerticalFacing::DOWN:
+            return Vector<units::Game>{0, 1.0};
+        case VerticalFacing::LAST:
+            break;
+    }
+    return Vector<units::Game>{0, 0};
+}
+
+constexpr auto kGunSourceRows = makeEnumTable<units::Tile,
+      HorizontalFacing, VerticalFacing>(&getGunSourceRow);
+constexpr auto kGunOffsets = makeEnumTable<Vector<units::Game>,
+      HorizontalFacing, VerticalFacing>(&getGunOffset);
+constexpr auto kNozzleOffsets = makeEnumTable<Vector<units::Game>,
+      HorizontalFacing, VerticalFacing>(&getNozzleOffset);
+constexpr auto kProjectileDirections = makeEnumTable<Vector<units::Game>,
+      HorizontalFacing, VerticalFacing>(&getProjectileDirection);
+
+} // anonymous namespace
+
 PolarStar::PolarStar(Graphics& graphics) :
-    sprite_map_(),
-    horizontal_projectile_(),
-    vertical_projectile_(),
-    projectile_a_(),
-    projectile_b_()
+    sprites_(),
+    horizontal_projectile_{0},
+    vertical_projectile_{0},
+    projectiles_()
 {
     initializeSprites(graphics);
 }
@@ -56,16 +156,9 @@ PolarStar::~PolarStar() {}
 void PolarStar::updateProjectiles(std::chrono::milliseconds elapsed_time,
         const Map& map)
 {
-    if (projectile_a_) {
-        if (!projectile_a_->update(elapsed_time, map)) {
-            projectile_a_.reset();
-        }
-    }
-    if (projectile_b_) {
-        if (!projectile_b_->update(elapsed_time, map)) {
-            projectile_b_.reset();
-        }
-    }
+    projectiles_.retainIf([elapsed_time, &map](Projectile& projectile) {
+        return projectile.update(elapsed_time, map);
+    });
 }
 
 void PolarStar::draw(
@@ -76,14 +169,10 @@ void PolarStar::draw(
         Vector<units::Game> player_pos) const
 {
     const auto gun_pos = calcGunPos(player_pos, hfacing, vfacing, gun_up);
-    const auto state = SpriteState{hfacing, vfacing};
-    sprite_map_.at(state)->draw(graphics, gun_pos);
+    graphics.getSpriteRegistry().draw(sprites_(hfacing, vfacing), gun_pos);
 
-    if (projectile_a_ != nullptr) {
-        projectile_a_->draw(graphics);
-    }
-    if (projectile_b_ != nullptr) {
-        projectile_b_->draw(graphics);
+    for (const auto& projectile : projectiles_.view()) {
+        projectile.draw(graphics);
     }
 }
 
@@ -94,75 +183,79 @@ void PolarStar::startFire(
         bool gun_up
         )
 {
-    if (projectile_a_ != nullptr && projectile_b_ != nullptr) {
+    if (projectiles_.full()) {
         return;
     }
     const auto gun_pos = calcGunPos(player_pos, hfacing, vfacing, gun_up);
     const auto bullet_pos = getBulletPos(gun_pos, hfacing, vfacing);
-    if (projectile_a_ == nullptr) {
-        projectile_a_ = std::make_shared<Projectile>(
-                    (vfacing == VerticalFacing::HORIZONTAL)
-                    ? horizontal_projectile_ : vertical_projectile_,
-                    hfacing,
-                    vfacing,
-                    bullet_pos);
-    } else if (projectile_b_ == nullptr) {
-        projectile_b_ = std::make_shared<Projectile>(
-                    (vfacing == VerticalFacing::HORIZONTAL)
-                    ? horizontal_projectile_ : vertical_projectile_,
-                    hfacing,
-                    vfacing,
-                    bullet_pos);
-    }
+    projectiles_.spawn(Projectile(
+                (vfacing == VerticalFacing::HORIZONTAL)
+                ? horizontal_projectile_ : vertical_projectile_,
+                hfacing,
+                vfacing,
+                bullet_pos));
 }
 
 void PolarStar::stopFire() {}
 
-PolarStar::Projectile::Projectile(std::shared_ptr<Sprite> sprite,
+PolarStar::Projectile::Projectile() :
+    pos_{0, 0},
+    horizontal_direction_(HorizontalFacing::LEFT),
+    vertical_direction_(VerticalFacing::HORIZONTAL),
+    sprite_{0},
+    offset_{0},
+    alive_{false}
+{}
+
+PolarStar::Projectile::Projectile(SpriteRegistry::Id sprite,
         const HorizontalFacing hdirection,
         const VerticalFacing vdirection,
         const Vector<units::Game> pos) :
     pos_(pos),
     horizontal_direction_(hdirection),
     vertical_direction_(vdirection),
-    sprite_(std::move(sprite)),
+    sprite_{sprite},
     offset_{0},
     alive_{true}
 {}
 
-std::vector<std::shared_ptr<GenericProjectile> > PolarStar::getProjectiles()
+ProjectileView<PolarStar::Projectile> PolarStar::getProjectiles()
 {
-    std::vector<std::shared_ptr<GenericProjectile> > projectiles;
-    if (projectile_a_) {
-        projectiles.push_back(projectile_a_);
-    }
-    if (projectile_b_) {
-        projectiles.push_back(projectile_b_);
-    }
+    return projectiles_.view();
+}
+
+void PolarStar::save(StateWriter& writer) const
+{
+    projectiles_.save(writer);
+}
 
-    return projectiles;
+void PolarStar::restore(StateReader& reader)
+{
+    projectiles_.restore(reader);
 }
 
 bool PolarStar::Projectile::update(std::chrono::milliseconds elapsed_time,
         const Map &map)
 {
+    const Rectangle start_rect = getCollisionRectangle();
+    const auto start_pos = getPos();
     offset_ += kProjectileSpeed * elapsed_time.count();
+    const auto end_pos = getPos();
 
-    const std::vector<Map::CollisionTile> colliding_tiles{
-        map.getCollidingTiles(getCollisionRectangle())
+    // Sweep the whole step so fast projectiles cannot skip over a wall
+    const Vector<units::Game> delta{
+        end_pos.x - start_pos.x,
+        end_pos.y - start_pos.y
     };
-
-    for (auto &tile : colliding_tiles) {
-        if (tile.tile_type == Map::TileType::WALL) {
-            return false;
-        }
+    if (sweepRectangle(map, start_rect, delta).hit) {
+        return false;
     }
     return alive_ && offset_ < kProjectileMaxOffset;
 }
 
 void PolarStar::Projectile::draw(Graphics& graphics) const
 {
-    sprite_->draw(graphics, getPos());
+    graphics.getSpriteRegistry().draw(sprite_, getPos());
 }
 
 Rectangle PolarStar::Projectile::getCollisionRectangle() const
@@ -190,37 +283,34 @@ void PolarStar::Projectile::collideWithEnemy()
     alive_ = false;
 }
 
-Vector<units::Game> PolarStar::Projectile::getPos() const
+void PolarStar::Projectile::save(StateWriter& writer) const
 {
-    units::Game x = pos_.x;
-    units::Game y = pos_.y;
-    if (vertical_direction_ == VerticalFacing::HORIZONTAL) {
-        x += (horizontal_direction_ == HorizontalFacing::LEFT)
-            ? -offset_
-            : offset_;
-    }
-    switch (vertical_direction_) {
-    case VerticalFacing::HORIZONTAL:
-        break;
-    case VerticalFacing::UP:
-        y -= offset_;
-        break;
-    case VerticalFacing::DOWN:
-        y += offset_;
-        break;
-    default: break;
-    }
-    return Vector<units::Game>{ x, y };
+    writer.write(pos_);
+    writer.write(horizontal_direction_);
+    writer.write(vertical_direction_);
+    writer.write(sprite_);
+    writer.write(offset_);
+    writer.write(alive_);
 }
 
-auto PolarStar::SpriteState::rank() const
+void PolarStar::Projectile::restore(StateReader& reader)
 {
-    return std::tie(horizontal_facing, vertical_facing);
+    reader.read(pos_);
+    reader.read(horizontal_direction_);
+    reader.read(vertical_direction_);
+    reader.read(sprite_);
+    reader.read(offset_);
+    reader.read(alive_);
 }
 
-bool operator<(const PolarStar::SpriteState& a, const PolarStar::SpriteState& b)
+Vector<units::Game> PolarStar::Projectile::getPos() const
 {
-    return a.rank() < b.rank();
+    const auto direction =
+        kProjectileDirections(horizontal_direction_, vertical_direction_);
+    return Vector<units::Game>{
+        pos_.x + direction.x * offset_,
+        pos_.y + direction.y * offset_
+    };
 }
 
 const Vector<units::Game> PolarStar::calcGunPos(
@@ -230,21 +320,7 @@ const Vector<units::Game> PolarStar::calcGunPos(
         const bool gun_up
         ) const
 {
-    Vector<units::Game> pos(player_pos);
-    if (hfacing == HorizontalFacing::LEFT) {
-        pos.x -= units::kHalfTile;
-    }
-    switch (vfacing) {
-        case VerticalFacing::UP:
-            pos.y -= units::kHalfTile / 2;
-            break;
-        case VerticalFacing::DOWN:
-            pos.y += units::kHalfTile / 2;
-            break;
-        case VerticalFacing::HORIZONTAL:
-        case VerticalFacing::LAST:
-            break;
-    }
+    Vector<units::Game> pos = player_pos + kGunOffsets(hfacing, vfacing);
     if (gun_up) {
         pos.y -= kGunBob;
     }
@@ -257,111 +333,31 @@ const Vector<units::Game> PolarStar::getBulletPos(
         const VerticalFacing vfacing
         ) const
 {
-    auto bullet_x = player_pos.x - units::kHalfTile;
-    auto bullet_y = player_pos.y - units::kHalfTile;
-
-    switch (vfacing) {
-        case VerticalFacing::HORIZONTAL:
-            bullet_y += kNozzleHorizontalY;
-
-            switch (hfacing) {
-                case HorizontalFacing::LEFT:
-                    bullet_x += kNozzleHorizontalLeftX;
-                    break;
-                case HorizontalFacing::RIGHT:
-                    bullet_x += kNozzleHorizontalRightX;
-                    break;
-                default:
-                    break;
-            }
-
-            break;
-        case VerticalFacing::UP:
-            bullet_y += kNozzleUpY;
-
-            switch (hfacing) {
-                case HorizontalFacing::LEFT:
-                    bullet_x += kNozzleUpLeftX;
-                    break;
-                case HorizontalFacing::RIGHT:
-                    bullet_x += kNozzleUpRightX;
-                    break;
-                default:
-                    break;
-            }
-
-            break;
-        case VerticalFacing::DOWN:
-            bullet_y += kNozzleDownY;
-
-            switch (hfacing) {
-                case HorizontalFacing::LEFT:
-                    bullet_x += kNozzleDownLeftX;
-                    break;
-                case HorizontalFacing::RIGHT:
-                    bullet_x += kNozzleDownRightX;
-                    break;
-                default:
-                    break;
-            }
-
-            break;
-        default:
-            break;
-    }
-
-    return Vector<units::Game>{bullet_x, bullet_y};
+    const auto nozzle = kNozzleOffsets(hfacing, vfacing);
+    return Vector<units::Game>{
+        player_pos.x - units::kHalfTile + nozzle.x,
+        player_pos.y - units::kHalfTile + nozzle.y
+    };
 }
 
 void PolarStar::initializeSprites(Graphics& graphics)
 {
-    horizontal_projectile_ = std::make_shared<Sprite>(
-                graphics, "Bullet",
+    SpriteRegistry& sprites = graphics.getSpriteRegistry();
+    horizontal_projectile_ = sprites.add("Bullet",
                 units::tileToPixel(kHorizontalProjectileSourceX),
                 units::tileToPixel(kProjectileSourceY),
                 units::tileToPixel(kProjectileSourceWidth),
                 units::tileToPixel(kProjectileSourceHeight));
-    vertical_projectile_ = std::make_shared<Sprite>(
-                graphics, "Bullet",
+    vertical_projectile_ = sprites.add("Bullet",
                 units::tileToPixel(kVerticalProjectileSourceX),
                 units::tileToPixel(kProjectileSourceY),
                 units::tileToPixel(kProjectileSourceWidth),
                 units::tileToPixel(kProjectileSourceHeight));
-    for (auto hf = HorizontalFacing::FIRST; hf != HorizontalFacing::LAST; ++hf) {
-        for (auto vf = VerticalFacing::FIRST; vf != VerticalFacing::LAST; ++vf) {
-            initializeSprite(graphics, SpriteState(hf, vf));
-        }
-    }
-}
-
-void PolarStar::initializeSprite(
-        Graphics& graphics,
-        const SpriteState& sprite_state)
-{
-    units::Tile tile_y;
-    if (sprite_state.horizontal_facing == HorizontalFacing::LEFT) {
-        tile_y = kLeftOffset;
-    } else {
-        tile_y = kRightOffset;
-    }
-    switch (sprite_state.vertical_facing) {
-        case VerticalFacing::HORIZONTAL:
-            tile_y += kHorizontalOffset;
-            break;
-        case VerticalFacing::UP:
-            tile_y += kUpOffset;
-            break;
-        case VerticalFacing::DOWN:
-            tile_y += kDownOffset;
-            break;
-        case VerticalFacing::LAST:
-            break;
-    }
-    sprite_map_[sprite_state] = std::make_shared<Sprite>(graphics,
-                kArmsSpritePath,
+    for (std::size_t i = 0; i < kGunSourceRows.size(); ++i) {
+        sprites_.values[i] = sprites.add(kArmsSpritePath,
                 units::gameToPixel(kPolarStarIndex * kGunWidth),
-                units::tileToPixel(tile_y),
+                units::tileToPixel(kGunSourceRows.values[i]),
                 units::gameToPixel(kGunWidth),
                 units::gameToPixel(kGunHeight));
+    }
 }
-
@@ -2,18 +2,49 @@
 #define POLAR_STAR_H_
 
 #include <chrono>
-#include <vector>
+#include <cstddef>
+#include "enum_table.h"
 #include "projectile.h"
+#include "projectile_pool.h"
 #include "rectangle.h"
+#include "sprite_registry.h"
 #include "sprite_state.h"
 #include "units.h"
 #include "vector.h"
 
 struct Graphics;
 struct Map;
-struct Sprite;
+struct StateReader;
+struct StateWriter;
 
 struct PolarStar {
+    struct Projectile final : public GenericProjectile {
+        // An empty slot of the pool
+        Projectile();
+        Projectile(SpriteRegistry::Id sprite,
+                const HorizontalFacing hdirection,
+                const VerticalFacing vdirection,
+                const Vector<units::Game> pos);
+        // Returns true if |this} are alive.
+        bool update(std::chrono::milliseconds elapsed_time, const Map& map);
+        void draw(Graphics& graphics) const;
+        Rectangle getCollisionRectangle() const override;
+        units::HP getContactDamage() const override;
+        void collideWithEnemy() override;
+
+        void save(StateWriter& writer) const;
+        void restore(StateReader& reader);
+    private:
+        Vector<units::Game> getPos() const;
+
+        Vector<units::Game> pos_;
+        HorizontalFacing horizontal_direction_;
+        VerticalFacing vertical_direction_;
+        SpriteRegistry::Id sprite_;
+        units::Game offset_;
+        bool alive_;
+    };
+
     PolarStar(Graphics& graphics);
     ~PolarStar();
 
@@ -30,7 +61,11 @@ struct PolarStar {
             bool gun_up
             );
     void stopFire();
-    std::vector<std::shared_ptr<GenericProjectile> > getProjectiles();
+    ProjectileView<Projectile> getProjectiles();
+
+    // Savestate of the projectiles in flight
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
 private:
     const Vector<units::Game> calcGunPos(
             const Vector<units::Game> player_pos,
@@ -44,52 +79,13 @@ private:
             const VerticalFacing vfacing
             ) const;
 
-    struct Projectile : public GenericProjectile {
-        Projectile(std::shared_ptr<Sprite> sprite,
-                const HorizontalFacing hdirection,
-                const VerticalFacing vdirection,
-                const Vector<units::Game> pos);
-        // Returns true if |this} are alive.
-        bool update(std::chrono::milliseconds elapsed_time, const Map& map);
-        void draw(Graphics& graphics) const;
-        Rectangle getCollisionRectangle() const override;
-        units::HP getContactDamage() const override;
-        void collideWithEnemy() override;
-    private:
-        Vector<units::Game> getPos() const;
-
-        Vector<units::Game> pos_;
-        HorizontalFacing horizontal_direction_;
-        VerticalFacing vertical_direction_;
-        std::shared_ptr<Sprite> sprite_;
-        units::Game offset_;
-        bool alive_;
-    };
-
-    struct SpriteState {
-        SpriteState(
-                HorizontalFacing horizontal_facing,
-                VerticalFacing vertical_facing
-                ) :
-            horizontal_facing{horizontal_facing},
-            vertical_facing{vertical_facing}
-        {}
-
-        auto rank() const;
-
-        HorizontalFacing horizontal_facing;
-        VerticalFacing vertical_facing;
-    };
-    friend bool operator<(const SpriteState& a, const SpriteState& b);
-
     void initializeSprites(Graphics& graphics);
-    void initializeSprite(Graphics& graphics, const SpriteState& sprite_state);
 
-    std::map<SpriteState, std::shared_ptr<Sprite> > sprite_map_;
-    std::shared_ptr<Sprite> horizontal_projectile_;
-    std::shared_ptr<Sprite> vertical_projectile_;
-    std::shared_ptr<Projectile> projectile_a_;
-    std::shared_ptr<Projectile> projectile_b_;
+    EnumTable<SpriteRegistry::Id, HorizontalFacing, VerticalFacing> sprites_;
+    SpriteRegistry::Id horizontal_projectile_;
+    SpriteRegistry::Id vertical_projectile_;
+    static const std::size_t kMaxProjectiles{2};
+    ProjectilePool<Projectile, kMaxProjectiles> projectiles_;
 };
 
 #endif /* POLAR_STAR_H_ */
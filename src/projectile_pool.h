@@ -0,0 +1,204 @@
+#ifndef PROJECTILE_POOL_H_
+#define PROJECTILE_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "savestate.h"
+
+// Non-owning range over the live projectiles of a pool. Valid until the
+// pool next spawns or removes a projectile.
+template <typename T>
+struct ProjectileView {
+    ProjectileView(T* first, T* last) :
+        first_{first},
+        last_{last}
+    {}
+
+    T* begin() const { return first_; }
+    T* end() const { return last_; }
+    std::size_t size() const { return last_ - first_; }
+    bool empty() const { return first_ == last_; }
+
+private:
+    T* first_;
+    T* last_;
+};
+
+// Fixed-capacity storage for the projectiles of one weapon, which picks
+// its own |Capacity|. Live projectiles are packed at the front of an
+// inline array, so iterating them is a linear walk, and spawning copies
+// into that array instead of allocating. T must be default constructible,
+// copy assignable, and save and restore itself like the pool does.
+//
+// Removal moves the last projectile into the hole. Handles stay valid
+// through such moves; they go stale once their own projectile is removed.
+template <typename T, std::size_t Capacity>
+struct ProjectilePool {
+    struct Handle {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    ProjectilePool();
+    ProjectilePool(const ProjectilePool&)=delete;
+    ProjectilePool& operator=(const ProjectilePool&)=delete;
+
+    std::size_t size() const { return size_; }
+    bool full() const { return size_ == Capacity; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // Returns false, spawning nothing, when the pool is full.
+    bool spawn(const T& projectile, Handle* handle=nullptr);
+    // nullptr once the projectile is gone
+    T* get(Handle handle);
+    void clear();
+
+    // Calls keep(T&) once on every projectile and removes those for which
+    // it returns false.
+    template <typename Keep>
+    void retainIf(Keep keep);
+
+    ProjectileView<T> view() { return {items_, items_ + size_}; }
+    ProjectileView<const T> view() const { return {items_, items_ + size_}; }
+
+    // Savestate of the live projectiles and of the handles, so handles
+    // taken before a save resolve the same way after restoring it
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
+
+private:
+    void remove(std::size_t position);
+
+    T items_[Capacity];
+    std::size_t size_;
+    // Handle index of the projectile at each position
+    uint32_t owner_[Capacity];
+    // Position of the projectile behind each handle index
+    uint32_t position_[Capacity];
+    uint32_t generation_[Capacity];
+    // Stack of unused handle indices
+    uint32_t free_[Capacity];
+    std::size_t num_free_;
+};
+
+template <typename T, std::size_t Capacity>
+ProjectilePool<T, Capacity>::ProjectilePool() :
+    items_(),
+    size_{0},
+    owner_(),
+    position_(),
+    generation_(),
+    free_(),
+    num_free_{0}
+{
+    clear();
+}
+
+template <typename T, std::size_t Capacity>
+bool ProjectilePool<T, Capacity>::spawn(const T& projectile, Handle* handle)
+{
+    if (full()) {
+        return false;
+    }
+    const uint32_t index = free_[--num_free_];
+    items_[size_] = projectile;
+    owner_[size_] = index;
+    position_[index] = size_;
+    ++size_;
+    if (handle != nullptr) {
+        *handle = Handle{index, generation_[index]};
+    }
+    return true;
+}
+
+template <typename T, std::size_t Capacity>
+T* ProjectilePool<T, Capacity>::get(Handle handle)
+{
+    if (handle.index >= Capacity ||
+            generation_[handle.index] != handle.generation) {
+        return nullptr;
+    }
+    const uint32_t position = position_[handle.index];
+    if (position >= size_ || owner_[position] != handle.index) {
+        return nullptr;
+    }
+    return &items_[position];
+}
+
+template <typename T, std::size_t Capacity>
+void ProjectilePool<T, Capacity>::clear()
+{
+    for (std::size_t i = 0; i < size_; ++i) {
+        ++generation_[owner_[i]];
+    }
+    size_ = 0;
+    num_free_ = Capacity;
+    for (std::size_t i = 0; i < Capacity; ++i) {
+        free_[i] = static_cast<uint32_t>(Capacity - 1 - i);
+    }
+}
+
+template <typename T, std::size_t Capacity>
+template <typename Keep>
+void ProjectilePool<T, Capacity>::retainIf(Keep keep)
+{
+    // The projectile moved into a hole has not been visited yet
+    for (std::size_t i = 0; i < size_; ) {
+        if (keep(items_[i])) {
+            ++i;
+        } else {
+            remove(i);
+        }
+    }
+}
+
+template <typename T, std::size_t Capacity>
+void ProjectilePool<T, Capacity>::save(StateWriter& writer) const
+{
+    writer.write(size_);
+    for (std::size_t i = 0; i < size_; ++i) {
+        items_[i].save(writer);
+    }
+    writer.write(owner_);
+    writer.write(position_);
+    writer.write(generation_);
+    writer.write(free_);
+    writer.write(num_free_);
+}
+
+template <typename T, std::size_t Capacity>
+void ProjectilePool<T, Capacity>::restore(StateReader& reader)
+{
+    std::size_t size{0};
+    reader.read(size);
+    if (size > Capacity) {
+        throw std::runtime_error("Savestate holds too many projectiles");
+    }
+    size_ = size;
+    for (std::size_t i = 0; i < size_; ++i) {
+        items_[i].restore(reader);
+    }
+    reader.read(owner_);
+    reader.read(position_);
+    reader.read(generation_);
+    reader.read(free_);
+    reader.read(num_free_);
+}
+
+template <typename T, std::size_t Capacity>
+void ProjectilePool<T, Capacity>::remove(std::size_t position)
+{
+    const uint32_t index = owner_[position];
+    ++generation_[index];
+    free_[num_free_++] = index;
+
+    const std::size_t last = --size_;
+    if (position != last) {
+        items_[position] = items_[last];
+        owner_[position] = owner_[last];
+        position_[owner_[position]] = position;
+    }
+}
+
+#endif /* PROJECTILE_POOL_H_ */
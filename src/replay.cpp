@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "replay.h"
+
+const units::Frame Replay::kDefaultKeyframeInterval;
+
+namespace {
+
+const char kReplayMagic[8] = {'C', 'A', 'V', 'E', 'R', 'E', 'P', '2'};
+
+} // anonymous namespace
+
+Replay::Replay(uint64_t seed, units::Frame keyframe_interval) :
+    seed_{seed},
+    keyframe_interval_{keyframe_interval},
+    num_frames_{0},
+    segments_(),
+    final_state_()
+{
+    if (keyframe_interval == 0) {
+        throw std::runtime_error("Replay keyframe interval must be positive");
+    }
+}
+
+Replay Replay::load(const std::string& file_path)
+{
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open replay '" + file_path + "'");
+    }
+    SaveState contents;
+    contents.bytes.assign(std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+
+    try {
+        StateReader reader(contents);
+        char magic[sizeof(kReplayMagic)];
+        reader.read(magic);
+        if (std::memcmp(magic, kReplayMagic, sizeof(kReplayMagic)) != 0) {
+            throw std::runtime_error("not a replay file");
+        }
+        uint64_t seed{0};
+        units::Frame keyframe_interval{0};
+        units::Frame num_frames{0};
+        units::Frame num_segments{0};
+        reader.read(seed);
+        reader.read(keyframe_interval);
+        reader.read(num_frames);
+        reader.read(num_segments);
+
+        Replay replay(seed, keyframe_interval);
+        // Every segment takes more than a byte, which bounds the count
+        // before anything is allocated for it
+        if (num_segments > contents.bytes.size() ||
+                num_segments != num_frames / keyframe_interval +
+                (num_frames % keyframe_interval != 0)) {
+            throw std::runtime_error("wrong number of segments");
+        }
+        replay.num_frames_ = num_frames;
+        replay.segments_.resize(num_segments);
+        for (units::Frame i = 0; i < num_segments; ++i) {
+            Segment& segment = replay.segments_[i];
+            reader.readArray(segment.keyframe.bytes);
+            reader.readArray(segment.runs);
+            reader.readArray(segment.hashes);
+            const units::Frame expected_length = std::min(keyframe_interval,
+                    num_frames - i * keyframe_interval);
+            units::Frame length{0};
+            for (const auto& run : segment.runs) {
+                length += run.num_frames;
+            }
+            if (length != expected_length ||
+                    segment.hashes.size() != expected_length) {
+                throw std::runtime_error("segment " + std::to_string(i) +
+                        " has the wrong number of frames");
+            }
+        }
+        reader.readArray(replay.final_state_.bytes);
+        reader.finish();
+        return replay;
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error("Replay '" + file_path + "' is corrupt: " +
+                error.what());
+    }
+}
+
+void Replay::save(const std::string& file_path) const
+{
+    SaveState contents;
+    StateWriter writer(contents);
+    writer.write(kReplayMagic);
+    writer.write(seed_);
+    writer.write(keyframe_interval_);
+    writer.write(num_frames_);
+    writer.write(getNumSegments());
+    for (const auto& segment : segments_) {
+        writer.writeArray(segment.keyframe.bytes);
+        writer.writeArray(segment.runs);
+        writer.writeArray(segment.hashes);
+    }
+    writer.writeArray(final_state_.bytes);
+
+    std::ofstream file(file_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(contents.bytes.data()),
+            contents.bytes.size());
+    if (!file) {
+        throw std::runtime_error("Cannot write replay '" + file_path + "'");
+    }
+}
+
+uint64_t Replay::getSeed() const
+{
+    return seed_;
+}
+
+units::Frame Replay::getKeyframeInterval() const
+{
+    return keyframe_interval_;
+}
+
+units::Frame Replay::getNumFrames() const
+{
+    return num_frames_;
+}
+
+units::Frame Replay::getNumSegments() const
+{
+    return segments_.size();
+}
+
+bool Replay::needsKeyframe() const
+{
+    return num_frames_ == segments_.size() * keyframe_interval_;
+}
+
+SaveState& Replay::addKeyframe()
+{
+    segments_.emplace_back();
+    return segments_.back().keyframe;
+}
+
+void Replay::addFrame(const InputFrame& input, uint64_t hash)
+{
+    if (needsKeyframe()) {
+        throw std::runtime_error("Replay frame " + std::to_string(num_frames_) +
+                " has no keyframe");
+    }
+    Segment& segment = segments_.back();
+    if (segment.runs.empty() || segment.runs.back().input != input) {
+        segment.runs.push_back(InputRun{0, input});
+    }
+    ++segment.runs.back().num_frames;
+    segment.hashes.push_back(hash);
+    ++num_frames_;
+}
+
+SaveState& Replay::finish()
+{
+    return final_state_;
+}
+
+const SaveState& Replay::getKeyframe(units::Frame segment) const
+{
+    return segments_.at(segment).keyframe;
+}
+
+const SaveState& Replay::getFinalState() const
+{
+    return final_state_;
+}
+
+InputFrame Replay::getInput(units::Frame frame) const
+{
+    // Runs only break on input changes, so a segment holds few of them
+    const Segment& segment = segments_.at(frame / keyframe_interval_);
+    units::Frame offset = frame % keyframe_interval_;
+    for (const auto& run : segment.runs) {
+        if (offset < run.num_frames) {
+            return run.input;
+        }
+        offset -= run.num_frames;
+    }
+    throw std::runtime_error("Replay has no frame " + std::to_string(frame));
+}
+
+uint64_t Replay::getHash(units::Frame frame) const
+{
+    return segments_.at(frame / keyframe_interval_)
+        .hashes.at(frame % keyframe_interval_);
+}
+
+SeekBenchmark::SeekBenchmark() :
+    num_seeks{100},
+    first_segment{0},
+    num_segments{0},
+    seed{1}
+{}
+
+RecordConfig::RecordConfig() :
+    file_path(),
+    keyframe_interval{Replay::kDefaultKeyframeInterval},
+    bot_frames{0},
+    seed{std::random_device{}()}
+{}
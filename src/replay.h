@@ -0,0 +1,113 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "input.h"
+#include "savestate.h"
+#include "units.h"
+
+// A recorded session that can be played from any frame. Frames are split
+// into segments of getKeyframeInterval() frames; each segment starts with
+// a keyframe, the savestate of the world before its first frame, followed
+// by its inputs as (count, InputFrame) runs and the hashState() of the
+// world after each frame. Seeking to a frame restores one keyframe and
+// simulates at most a segment's worth of inputs, and each segment can be
+// replayed and checked on its own, down to the first frame that differs.
+//
+// On disk (host byte order, the same build only, like savestates):
+//   "CAVEREP2", seed, keyframe interval, frame count, segment count
+//   per segment: keyframe size and bytes, run count and runs, hash count
+//   and hashes
+//   size and bytes of the world after the last frame
+struct Replay {
+    static const units::Frame kDefaultKeyframeInterval{300};
+
+    // Empty replay of a world started from |seed|
+    Replay(uint64_t seed, units::Frame keyframe_interval);
+
+    // Throws std::runtime_error on unreadable or corrupt files.
+    static Replay load(const std::string& file_path);
+    // Throws std::runtime_error if the file cannot be written.
+    void save(const std::string& file_path) const;
+
+    uint64_t getSeed() const;
+    units::Frame getKeyframeInterval() const;
+    units::Frame getNumFrames() const;
+    units::Frame getNumSegments() const;
+
+    // Recording adds frames in order. A frame that starts a segment needs
+    // its keyframe first: save the world into addKeyframe() before the
+    // frame's input is applied.
+    bool needsKeyframe() const;
+    SaveState& addKeyframe();
+    // |hash| is the hashState() of the world after the frame. Throws
+    // std::runtime_error if the frame is missing its keyframe.
+    void addFrame(const InputFrame& input, uint64_t hash);
+    // Ends the recording; save the world after the last frame into it
+    SaveState& finish();
+
+    // The world before the first frame of |segment|
+    const SaveState& getKeyframe(units::Frame segment) const;
+    // The world after the last frame
+    const SaveState& getFinalState() const;
+    InputFrame getInput(units::Frame frame) const;
+    // The world's hash after |frame|
+    uint64_t getHash(units::Frame frame) const;
+
+private:
+    // |num_frames| frames in a row with the same input
+    struct InputRun {
+        uint32_t num_frames;
+        InputFrame input;
+    };
+
+    struct Segment {
+        Segment() :
+            keyframe(),
+            runs(),
+            hashes()
+        {}
+
+        SaveState keyframe;
+        std::vector<InputRun> runs;
+        std::vector<uint64_t> hashes;
+    };
+
+    uint64_t seed_;
+    units::Frame keyframe_interval_;
+    units::Frame num_frames_;
+    std::vector<Segment> segments_;
+    SaveState final_state_;
+};
+
+// What Game(const Replay&, const SeekBenchmark&) measures
+struct SeekBenchmark {
+    SeekBenchmark();
+
+    // Random frames to seek to
+    std::size_t num_seeks;
+    // Segments to replay and check against the next keyframe first, one
+    // after another. They are independent, but the world clock is still
+    // process-wide, so checking them in parallel is left for later.
+    units::Frame first_segment;
+    // 0 checks every segment from first_segment on
+    units::Frame num_segments;
+    uint64_t seed;
+};
+
+// How Game(const RecordConfig&) records a replay
+struct RecordConfig {
+    RecordConfig();
+
+    std::string file_path;
+    units::Frame keyframe_interval;
+    // Records this many frames of InputBot input offscreen instead of
+    // playing in a window; 0 plays
+    units::Frame bot_frames;
+    uint64_t seed;
+};
+
+#endif /* REPLAY_H_ */
@@ -0,0 +1,89 @@
+#include <cmath>
+#include "rng.h"
+#include "savestate.h"
+
+namespace {
+
+const uint64_t kGoldenGamma{0x9e3779b97f4a7c15};
+// 2^-53, the spacing of doubles in [0.5, 1): 53 random bits map onto
+// [0, 1) exactly
+const double kUnit{1.0 / static_cast<double>(uint64_t{1} << 53)};
+
+// Finalizer of SplitMix64 (Stafford's Mix13)
+uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+} // anonymous namespace
+
+Rng::Rng(uint64_t seed) :
+    state_{seed}
+{}
+
+uint64_t Rng::next()
+{
+    state_ += kGoldenGamma;
+    return mix(state_);
+}
+
+double Rng::uniform(double low, double high)
+{
+    const double unit = static_cast<double>(next() >> 11) * kUnit;
+    const double value = low + (high - low) * unit;
+    // Rounding the product can land on |high| itself
+    return (value < high) ? value : std::nextafter(high, low);
+}
+
+uint32_t Rng::between(uint32_t low, uint32_t high)
+{
+    const uint64_t range = static_cast<uint64_t>(high) - low + 1;
+    return low + static_cast<uint32_t>(((next() >> 32) * range) >> 32);
+}
+
+units::Degrees Rng::angle()
+{
+    return uniform(0.0, 360.0);
+}
+
+Rng Rng::split(uint64_t stream) const
+{
+    return Rng(mix(state_ ^ mix(stream + kGoldenGamma)));
+}
+
+bool Rng::operator==(const Rng& other) const
+{
+    return state_ == other.state_;
+}
+
+RandomStreams::RandomStreams(uint64_t seed) :
+    seed_{seed},
+    streams_()
+{
+    const Rng root(seed);
+    for (std::size_t i = 0; i < streams_.size(); ++i) {
+        streams_.values[i] = root.split(i);
+    }
+}
+
+Rng& RandomStreams::get(Stream stream)
+{
+    return streams_(stream);
+}
+
+uint64_t RandomStreams::getSeed() const
+{
+    return seed_;
+}
+
+void RandomStreams::save(StateWriter& writer) const
+{
+    writer.write(streams_);
+}
+
+void RandomStreams::restore(StateReader& reader)
+{
+    reader.read(streams_);
+}
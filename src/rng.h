@@ -0,0 +1,58 @@
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <cstdint>
+#include "enum_table.h"
+#include "units.h"
+
+struct StateReader;
+struct StateWriter;
+
+// Small, fast pseudo random generator (SplitMix64): eight bytes of state,
+// and the same sequence for the same seed on every platform and standard
+// library. Copying an Rng copies its position in the sequence.
+struct Rng {
+    explicit Rng(uint64_t seed=0);
+
+    uint64_t next();
+    // Uniform in [low, high)
+    double uniform(double low, double high);
+    // Uniform in [low, high], both included
+    uint32_t between(uint32_t low, uint32_t high);
+    units::Degrees angle();
+
+    // New generator for |stream|, independent of this one and of the
+    // other streams split from the same state
+    Rng split(uint64_t stream) const;
+
+    bool operator==(const Rng& other) const;
+
+private:
+    uint64_t state_;
+};
+
+// The random streams of one world, all derived from a single seed. Every
+// subsystem draws from its own stream, so adding draws to one leaves the
+// others, and anything replayed from the seed, unchanged.
+struct RandomStreams {
+    enum class Stream {
+        SPAWNS,
+        PARTICLES,
+        LAST
+    };
+
+    explicit RandomStreams(uint64_t seed);
+
+    Rng& get(Stream stream);
+    uint64_t getSeed() const;
+
+    // Savestate of the position of every stream
+    void save(StateWriter& writer) const;
+    void restore(StateReader& reader);
+
+private:
+    uint64_t seed_;
+    EnumTable<Rng, Stream> streams_;
+};
+
+#endif /* RNG_H_ */
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "rollback_session.h"
+#include "udp_link.h"
+
+const std::size_t RollbackSession::kNumPlayers;
+const units::Frame RollbackSession::kMaxRollback;
+const units::Frame RollbackSession::kWindow;
+
+namespace {
+
+const uint32_t kMagic{0x43535242}; // "CSRB"
+// Unacknowledged inputs resent per packet; losing a packet costs nothing
+// as long as a later one gets through
+const units::Frame kMaxInputsPerPacket{32};
+
+// Packets are raw bytes in the sender's layout, so both peers must run the
+// same build on machines of the same endianness
+struct PacketHeader {
+    uint32_t magic;
+    uint32_t input_delay;
+    // Next frame the sender will simulate, and how far that is ahead of the
+    // latest frame it heard the receiver report
+    uint32_t frame;
+    int32_t advantage;
+    // The sender has every input of the receiver before this frame
+    uint32_t ack;
+    // Inputs of the sender for frames [first_input, first_input + num_inputs)
+    uint32_t first_input;
+    uint32_t num_inputs;
+};
+
+} // anonymous namespace
+
+RollbackSession::RollbackSession(DatagramLink& link, std::size_t local_player,
+        units::Frame input_delay) :
+    link_(link),
+    local_player_{local_player},
+    input_delay_{input_delay},
+    frame_{0},
+    rollback_frame_{0},
+    inputs_(),
+    confirmed_(),
+    simulated_remote_(),
+    remote_ack_{input_delay},
+    remote_frame_{0},
+    remote_advantage_{0},
+    packet_()
+{
+    if (local_player >= kNumPlayers) {
+        throw std::runtime_error("Netplay has two players");
+    }
+    if (input_delay >= kWindow / 2) {
+        throw std::runtime_error("Netplay input delay is too long");
+    }
+    // Nobody presses anything before the first delayed input lands
+    for (auto& confirmed : confirmed_) {
+        confirmed = input_delay;
+    }
+}
+
+units::Frame RollbackSession::getFrame() const
+{
+    return frame_;
+}
+
+std::size_t RollbackSession::getLocalPlayer() const
+{
+    return local_player_;
+}
+
+std::size_t RollbackSession::getRemotePlayer() const
+{
+    return 1 - local_player_;
+}
+
+void RollbackSession::poll()
+{
+    while (link_.receive(packet_)) {
+        receive(packet_);
+    }
+}
+
+units::Frame RollbackSession::getRollbackFrame() const
+{
+    return std::min(rollback_frame_, frame_);
+}
+
+bool RollbackSession::shouldWait() const
+{
+    if (frame_ >= confirmed_[getRemotePlayer()] + kMaxRollback) {
+        return true;
+    }
+    if (confirmed_[local_player_] >= getOldestNeeded() + kWindow) {
+        return true;
+    }
+    // Both peers see each other behind by the latency; the one that is
+    // further ahead than that lets the other catch up
+    const int32_t advantage = static_cast<int32_t>(frame_ - remote_frame_);
+    return (advantage - remote_advantage_) / 2 >= 1;
+}
+
+void RollbackSession::addLocalInput(const InputFrame& input)
+{
+    units::Frame& confirmed = confirmed_[local_player_];
+    inputs_[local_player_][confirmed % kWindow] = input;
+    ++confirmed;
+}
+
+InputFrame RollbackSession::getInput(std::size_t player,
+        units::Frame frame) const
+{
+    const units::Frame confirmed = confirmed_[player];
+    if (frame < confirmed) {
+        return inputs_[player][frame % kWindow];
+    }
+    if (confirmed == 0) {
+        return InputFrame{0, 0, 0};
+    }
+    // Keep holding what was held, without new presses or releases
+    const InputFrame& last = inputs_[player][(confirmed - 1) % kWindow];
+    return InputFrame{last.held, 0, 0};
+}
+
+void RollbackSession::simulated(units::Frame frame)
+{
+    simulated_remote_[frame % kWindow] = getInput(getRemotePlayer(), frame);
+    rollback_frame_ = std::max(rollback_frame_, frame + 1);
+    if (frame == frame_) {
+        ++frame_;
+    }
+}
+
+void RollbackSession::flush()
+{
+    const units::Frame first = remote_ack_;
+    const units::Frame num_inputs = std::min(
+            confirmed_[local_player_] - first, kMaxInputsPerPacket);
+    const PacketHeader header{
+        kMagic,
+        input_delay_,
+        frame_,
+        static_cast<int32_t>(frame_ - remote_frame_),
+        confirmed_[getRemotePlayer()],
+        first,
+        num_inputs
+    };
+
+    packet_.resize(sizeof(header) + num_inputs * sizeof(InputFrame));
+    std::memcpy(packet_.data(), &header, sizeof(header));
+    for (units::Frame i = 0; i < num_inputs; ++i) {
+        std::memcpy(&packet_[sizeof(header) + i * sizeof(InputFrame)],
+                &inputs_[local_player_][(first + i) % kWindow],
+                sizeof(InputFrame));
+    }
+    link_.send(packet_.data(), packet_.size());
+}
+
+units::Frame RollbackSession::getOldestNeeded() const
+{
+    const units::Frame oldest_rollback =
+        (frame_ > kMaxRollback) ? frame_ - kMaxRollback : 0;
+    return std::min(remote_ack_, oldest_rollback);
+}
+
+void RollbackSession::receive(const std::vector<unsigned char>& packet)
+{
+    PacketHeader header;
+    if (packet.size() < sizeof(header)) {
+        return;
+    }
+    std::memcpy(&header, packet.data(), sizeof(header));
+    if (header.magic != kMagic || header.num_inputs > kMaxInputsPerPacket ||
+            packet.size() !=
+            sizeof(header) + header.num_inputs * sizeof(InputFrame)) {
+        return;
+    }
+    if (header.input_delay != input_delay_) {
+        throw std::runtime_error("Netplay peers use different input delays");
+    }
+
+    // Packets can arrive out of order; only the newest says where the peer is
+    if (header.frame >= remote_frame_) {
+        remote_frame_ = header.frame;
+        remote_advantage_ = header.advantage;
+    }
+    remote_ack_ = std::max(remote_ack_,
+            std::min(header.ack, confirmed_[local_player_]));
+
+    const std::size_t remote = getRemotePlayer();
+    const units::Frame end = getOldestNeeded() + kWindow;
+    for (units::Frame i = 0; i < header.num_inputs; ++i) {
+        const units::Frame frame = header.first_input + i;
+        if (frame < confirmed_[remote]) {
+            continue;
+        }
+        // Inputs are taken in order; a gap waits for a resend
+        if (frame > confirmed_[remote] || frame >= end) {
+            break;
+        }
+        InputFrame input;
+        std::memcpy(&input,
+                &packet[sizeof(header) + i * sizeof(InputFrame)],
+                sizeof(input));
+        inputs_[remote][frame % kWindow] = input;
+        ++confirmed_[remote];
+        if (frame < frame_ && input != simulated_remote_[frame % kWindow]) {
+            rollback_frame_ = std::min(rollback_frame_, frame);
+        }
+    }
+}
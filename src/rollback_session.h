@@ -0,0 +1,87 @@
+#ifndef ROLLBACK_SESSION_H_
+#define ROLLBACK_SESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "input.h"
+#include "units.h"
+
+struct DatagramLink;
+
+// Input timeline of a two-player rollback netplay session. It does not
+// simulate anything itself; the owner steps the world through it:
+//
+//   poll() reads the peer's inputs. If getRollbackFrame() is before
+//   getFrame(), a frame already simulated used a wrong prediction: restore
+//   the world to that frame and simulate up to getFrame() again, calling
+//   simulated() for each frame. Unless shouldWait(), add the local input
+//   with addLocalInput(), simulate getFrame() with getInput() and call
+//   simulated(). Finally flush() sends the local inputs.
+//
+// Local inputs take effect |input_delay| frames after they are added. The
+// peer's inputs past the last one received are predicted by holding its
+// buttons as they were. Both peers must use the same delay.
+struct RollbackSession {
+    static const std::size_t kNumPlayers{2};
+    // Furthest the simulation runs ahead of the peer's confirmed inputs
+    static const units::Frame kMaxRollback{8};
+
+    RollbackSession(DatagramLink& link, std::size_t local_player,
+            units::Frame input_delay);
+
+    // Next frame to simulate
+    units::Frame getFrame() const;
+    std::size_t getLocalPlayer() const;
+    std::size_t getRemotePlayer() const;
+
+    // Reads every packet waiting on the link. Throws std::runtime_error on
+    // packets from a peer with a different input delay.
+    void poll();
+    // First frame to simulate again, or getFrame() if the predictions held
+    units::Frame getRollbackFrame() const;
+    // True when the simulation should skip this tick: it is too far ahead
+    // of the peer's inputs, or running faster than the peer
+    bool shouldWait() const;
+
+    void addLocalInput(const InputFrame& input);
+    // Confirmed input of |player| for |frame|, or its prediction
+    InputFrame getInput(std::size_t player, units::Frame frame) const;
+    // |frame| was simulated with getInput(); getFrame() moves past it
+    void simulated(units::Frame frame);
+
+    // Sends the local inputs the peer has not acknowledged yet
+    void flush();
+
+private:
+    // Inputs and predictions kept per player; a power of two
+    static const units::Frame kWindow{64};
+
+    // Oldest frame whose inputs may still be needed
+    units::Frame getOldestNeeded() const;
+    void receive(const std::vector<unsigned char>& packet);
+
+    DatagramLink& link_;
+    const std::size_t local_player_;
+    const units::Frame input_delay_;
+
+    units::Frame frame_;
+    units::Frame rollback_frame_;
+    // Inputs of each player, by frame modulo kWindow
+    InputFrame inputs_[kNumPlayers][kWindow];
+    // Every input before this frame is known
+    units::Frame confirmed_[kNumPlayers];
+    // Peer input each frame was last simulated with
+    InputFrame simulated_remote_[kWindow];
+
+    // The peer has every local input before this frame
+    units::Frame remote_ack_;
+    // Latest frame the peer reported simulating, and how far ahead of us
+    // it thought it was
+    units::Frame remote_frame_;
+    int32_t remote_advantage_;
+
+    std::vector<unsigned char> packet_;
+};
+
+#endif /* ROLLBACK_SESSION_H_ */
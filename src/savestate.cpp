@@ -0,0 +1,83 @@
+#include <stdexcept>
+#include "savestate.h"
+
+namespace {
+
+const uint64_t kHashMultiplier{0x9e3779b97f4a7c15ull};
+
+// Finalizer of SplitMix64, spreading every input bit over the output
+uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+} // anonymous namespace
+
+SaveState::SaveState() :
+    bytes()
+{}
+
+uint64_t hashState(const SaveState& state)
+{
+    // Eight bytes per step; savestates are mostly doubles and sizes
+    const unsigned char* data = state.bytes.data();
+    const std::size_t size = state.bytes.size();
+    uint64_t hash = size * kHashMultiplier;
+    std::size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * kHashMultiplier;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail{0};
+    if (i < size) {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    return mix(hash ^ tail);
+}
+
+StateWriter::StateWriter(SaveState& state) :
+    bytes_(state.bytes)
+{
+    bytes_.clear();
+}
+
+void StateWriter::writeBytes(const void* data, std::size_t size)
+{
+    // Range insert copies straight in, without zero filling first
+    const auto first = static_cast<const unsigned char*>(data);
+    bytes_.insert(bytes_.end(), first, first + size);
+}
+
+StateReader::StateReader(const SaveState& state) :
+    bytes_(state.bytes),
+    position_{0}
+{}
+
+void StateReader::finish() const
+{
+    if (position_ != bytes_.size()) {
+        throw std::runtime_error("Savestate has unread data");
+    }
+}
+
+void StateReader::checkAvailable(std::size_t count, std::size_t size) const
+{
+    // Divides so that a corrupt count cannot overflow
+    if (count > (bytes_.size() - position_) / size) {
+        throw std::runtime_error("Savestate is truncated");
+    }
+}
+
+void StateReader::readBytes(void* data, std::size_t size)
+{
+    checkAvailable(size);
+    if (size == 0) {
+        return;
+    }
+    std::memcpy(data, &bytes_[position_], size);
+    position_ += size;
+}
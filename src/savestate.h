@@ -0,0 +1,103 @@
+#ifndef SAVESTATE_H_
+#define SAVESTATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// A snapshot of the simulation in one contiguous buffer (see
+// Game::saveState()). Reusing a SaveState reuses its buffer, so taking
+// snapshots over and over stops allocating once it has grown to fit.
+struct SaveState {
+    SaveState();
+
+    std::vector<unsigned char> bytes;
+};
+
+// Fast non-cryptographic 64-bit hash of a snapshot. Equal states save
+// equal bytes, so equal hashes stand for equal worlds; it catches
+// divergence, not tampering.
+uint64_t hashState(const SaveState& state);
+
+// Serializes state into a SaveState, replacing what it held. Everything is
+// copied as raw bytes, so a snapshot only restores in the same build. Write
+// structs member by member unless they have no padding, so that equal
+// states give equal bytes.
+struct StateWriter {
+    explicit StateWriter(SaveState& state);
+
+    template <typename T>
+    void write(const T& value);
+    // Writes the size, then the elements in one copy
+    template <typename T>
+    void writeArray(const std::vector<T>& values);
+
+private:
+    void writeBytes(const void* data, std::size_t size);
+
+    std::vector<unsigned char>& bytes_;
+};
+
+// Reads state back in the order StateWriter wrote it. Throws
+// std::runtime_error when reading past the end of the snapshot.
+struct StateReader {
+    explicit StateReader(const SaveState& state);
+
+    template <typename T>
+    void read(T& value);
+    // Resizes |values| to the saved size; keeps its capacity
+    template <typename T>
+    void readArray(std::vector<T>& values);
+
+    // Throws std::runtime_error unless the whole snapshot was read
+    void finish() const;
+
+private:
+    // Throws unless |count| more items of |size| bytes are left
+    void checkAvailable(std::size_t count, std::size_t size=1) const;
+    void readBytes(void* data, std::size_t size);
+
+    const std::vector<unsigned char>& bytes_;
+    std::size_t position_;
+};
+
+template <typename T>
+void StateWriter::write(const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Only plain values can be written as bytes");
+    writeBytes(&value, sizeof(T));
+}
+
+template <typename T>
+void StateWriter::writeArray(const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Only plain values can be written as bytes");
+    write(values.size());
+    writeBytes(values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+void StateReader::read(T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Only plain values can be read as bytes");
+    readBytes(&value, sizeof(T));
+}
+
+template <typename T>
+void StateReader::readArray(std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Only plain values can be read as bytes");
+    std::size_t size{0};
+    read(size);
+    checkAvailable(size, sizeof(T));
+    values.resize(size);
+    readBytes(values.data(), size * sizeof(T));
+}
+
+#endif /* SAVESTATE_H_ */
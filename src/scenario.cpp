@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include "scenario.h"
+#include "game.h"
+#include "map.h"
+
+namespace {
+
+const char* const kSystemNames[SystemTimings::NUM_SYSTEMS] = {
+    "timers",
+    "particles",
+    "map",
+    "player",
+    "enemies",
+    "collisions",
+    "savestates",
+    "draw"
+};
+
+// Upper bounds of directive values; anything past them is a typo rather
+// than a stress test
+const long long kMaxBats{1000000};
+const double kMaxParticlesPerSecond{1000000.0};
+const long long kMaxSavestatesPerFrame{1000};
+const long long kMaxLatency{10000};
+
+// Reads a whole number in [min, max] into |value|. Anything else fails
+// |words| and leaves |value| alone, so "-1" cannot wrap into a huge count.
+template <typename T>
+void readNumber(std::istream& words, long long min, long long max, T& value)
+{
+    long long number{0};
+    if (words >> number && number >= min && number <= max) {
+        value = static_cast<T>(number);
+    } else {
+        words.setstate(std::ios::failbit);
+    }
+}
+
+void readNumber(std::istream& words, double min, double max, double& value)
+{
+    double number{0.0};
+    // Also rejects NaN, which compares false
+    if (words >> number && number >= min && number <= max) {
+        value = number;
+    } else {
+        words.setstate(std::ios::failbit);
+    }
+}
+
+} // anonymous namespace
+
+Scenario::Scenario() :
+    num_frames{600},
+    seed{1},
+    map_rows{0},
+    map_cols{0},
+    map_file(),
+    player{Game::kScreenWidth / 2, Game::kScreenHeight / 2},
+    bats(),
+    num_scattered_bats{0},
+    particles_per_second{0.0},
+    sustained_fire{false},
+    savestates_per_frame{0},
+    netplay{false},
+    netplay_latency{0},
+    netplay_loss{0.0}
+{}
+
+Scenario Scenario::load(const std::string& file_path)
+{
+    std::ifstream file(file_path);
+    if (!file) {
+        throw std::runtime_error("Cannot open scenario '" + file_path + "'");
+    }
+
+    Scenario scenario;
+    std::string line;
+    for (unsigned line_number = 1; std::getline(file, line); ++line_number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string directive;
+        if (!(words >> directive)) {
+            continue;
+        }
+
+        const long long max_tile = Map::kMaxCaveSize - 1;
+        if (directive == "frames") {
+            readNumber(words, 1, std::numeric_limits<units::Frame>::max(),
+                    scenario.num_frames);
+        } else if (directive == "seed") {
+            readNumber(words, 0, std::numeric_limits<unsigned>::max(),
+                    scenario.seed);
+        } else if (directive == "map") {
+            readNumber(words, Map::kMinCaveSize, Map::kMaxCaveSize,
+                    scenario.map_rows);
+            readNumber(words, Map::kMinCaveSize, Map::kMaxCaveSize,
+                    scenario.map_cols);
+        } else if (directive == "map_file") {
+            words >> scenario.map_file;
+        } else if (directive == "player") {
+            readNumber(words, 0, max_tile, scenario.player.x);
+            readNumber(words, 0, max_tile, scenario.player.y);
+        } else if (directive == "bat") {
+            Vector<units::Tile> bat{0, 0};
+            readNumber(words, 0, max_tile, bat.x);
+            readNumber(words, 0, max_tile, bat.y);
+            scenario.bats.push_back(bat);
+        } else if (directive == "bats") {
+            readNumber(words, 0, kMaxBats, scenario.num_scattered_bats);
+        } else if (directive == "particles") {
+            readNumber(words, 0.0, kMaxParticlesPerSecond,
+                    scenario.particles_per_second);
+        } else if (directive == "fire") {
+            scenario.sustained_fire = true;
+        } else if (directive == "savestates") {
+            readNumber(words, 0, kMaxSavestatesPerFrame,
+                    scenario.savestates_per_frame);
+        } else if (directive == "netplay") {
+            long latency{0};
+            double loss_percent{0.0};
+            readNumber(words, 0, kMaxLatency, latency);
+            readNumber(words, 0.0, 100.0, loss_percent);
+            scenario.netplay = true;
+            scenario.netplay_latency = std::chrono::milliseconds{latency};
+            scenario.netplay_loss = loss_percent / 100.0;
+        } else {
+            words.setstate(std::ios::failbit);
+        }
+        // Nothing may follow the values
+        std::string extra;
+        if (words.fail() || words >> extra) {
+            std::ostringstream error;
+            error << file_path << ":" << line_number
+                << ": bad directive '" << directive << "'";
+            throw std::runtime_error(error.str());
+        }
+    }
+    return scenario;
+}
+
+SystemTimings::Scope::Scope(SystemTimings& timings, System system) :
+    timings_(timings),
+    system_{system},
+    start_{std::chrono::high_resolution_clock::now()}
+{}
+
+SystemTimings::Scope::~Scope()
+{
+    timings_.add(system_, std::chrono::high_resolution_clock::now() - start_);
+}
+
+SystemTimings::SystemTimings() :
+    total_(),
+    worst_()
+{}
+
+void SystemTimings::add(System system, Milliseconds elapsed)
+{
+    total_[system] += elapsed;
+    worst_[system] = std::max(worst_[system], elapsed);
+}
+
+SystemTimings::Milliseconds SystemTimings::getTotal(System system) const
+{
+    return total_[system];
+}
+
+void SystemTimings::report(units::Frame num_frames) const
+{
+    // Formatted apart so the precision does not stick to std::cout
+    std::ostringstream lines;
+    lines << std::fixed << std::setprecision(3);
+    Milliseconds total{0};
+    for (int system = 0; system < NUM_SYSTEMS; ++system) {
+        lines << "  " << std::setw(10) << kSystemNames[system] << ": "
+            << total_[system].count() / num_frames << " ms/frame average, "
+            << worst_[system].count() << " ms worst\n";
+        total += total_[system];
+    }
+    lines << "  " << std::setw(10) << "total" << ": "
+        << total.count() / num_frames << " ms/frame average\n";
+    std::cout << lines.str();
+}
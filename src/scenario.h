@@ -0,0 +1,93 @@
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "units.h"
+#include "vector.h"
+
+// Population and length of a headless stress run (see Game(const
+// Scenario&)). Fill one in code, or read it from a text file holding one
+// directive per line; positions are in tiles and '#' starts a comment:
+//
+//   frames <count>
+//   seed <value>
+//   map <rows> <cols>         generated with Map::createCaveMap()
+//   map_file <path>           written by cave --write-map, streamed
+//   player <col> <row>
+//   bat <col> <row>
+//   bats <count>              scattered over the map
+//   particles <per second>    HeadBumpParticles at random spots
+//   fire                      holds the Polar Star trigger down
+//   savestates <per frame>    saves and restores the world before updates
+//   netplay <latency> <loss>  adds a second player, played by a LoopbackPeer
+//                             over UDP with |latency| ms each way and |loss|
+//                             percent of packets lost; particles and
+//                             savestates are ignored
+struct Scenario {
+    Scenario();
+
+    // Throws std::runtime_error on unreadable files, unknown directives and
+    // missing, out of range or trailing values.
+    static Scenario load(const std::string& file_path);
+
+    units::Frame num_frames;
+    unsigned seed;
+    // Generated map size; 0 x 0 keeps Map::createTestMap()
+    units::Tile map_rows;
+    units::Tile map_cols;
+    // Overrides the generated map when set
+    std::string map_file;
+    Vector<units::Tile> player;
+    std::vector<Vector<units::Tile> > bats;
+    std::size_t num_scattered_bats;
+    double particles_per_second;
+    bool sustained_fire;
+    // Save and restore round trips per frame, to time Game::saveState()
+    std::size_t savestates_per_frame;
+    bool netplay;
+    std::chrono::milliseconds netplay_latency;
+    // Fraction of packets lost
+    double netplay_loss;
+};
+
+// Wall time Game::update() and Game::draw() spend in each system
+struct SystemTimings {
+    enum System {
+        TIMERS,
+        PARTICLES,
+        MAP,
+        PLAYER,
+        ENEMIES,
+        COLLISIONS,
+        SAVESTATES,
+        DRAW,
+        NUM_SYSTEMS
+    };
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+    // Adds the time from construction to destruction to |system|
+    struct Scope {
+        Scope(SystemTimings& timings, System system);
+        ~Scope();
+    private:
+        SystemTimings& timings_;
+        const System system_;
+        const std::chrono::high_resolution_clock::time_point start_;
+    };
+
+    SystemTimings();
+
+    void add(System system, Milliseconds elapsed);
+    Milliseconds getTotal(System system) const;
+    // Prints the average and worst frame of every system
+    void report(units::Frame num_frames) const;
+
+private:
+    Milliseconds total_[NUM_SYSTEMS];
+    Milliseconds worst_[NUM_SYSTEMS];
+};
+
+#endif /* SCENARIO_H_ */
@@ -6,12 +6,14 @@
 
 struct SDLEngine
 {
-    SDLEngine()
+    // Headless runs pass 0: offscreen rendering needs no subsystem
+    explicit SDLEngine(Uint32 subsystems=SDL_INIT_VIDEO | SDL_INIT_JOYSTICK)
     {
-        if (SDL_Init(SDL_INIT_VIDEO| SDL_INIT_JOYSTICK) < 0) {
+        if (SDL_Init(subsystems) < 0) {
             throw std::runtime_error("SDL_Init");
         }
-        if (SDL_ShowCursor(SDL_DISABLE) < 0) {
+        if ((subsystems & SDL_INIT_VIDEO) &&
+                SDL_ShowCursor(SDL_DISABLE) < 0) {
             throw std::runtime_error("SDL_ShowCursor");
         }
     }
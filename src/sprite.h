@@ -21,7 +21,6 @@ struct Sprite {
     Sprite(const Sprite&)=delete;
     Sprite& operator=(const Sprite&)=delete;
 
-    virtual void update() {}
     void draw(Graphics& graphics, const Vector<units::Game>& pos) const;
 
 private:
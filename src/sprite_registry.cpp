@@ -0,0 +1,41 @@
+#include <limits>
+#include <stdexcept>
+#include "sprite_registry.h"
+#include "graphics.h"
+
+SpriteRegistry::SpriteRegistry(Graphics& graphics) :
+    graphics_(graphics),
+    definitions_()
+{}
+
+SpriteRegistry::Id SpriteRegistry::add(const std::string& file_name,
+        units::Pixel source_x, units::Pixel source_y,
+        units::Pixel width, units::Pixel height,
+        std::size_t count)
+{
+    if (definitions_.size() + count >
+            static_cast<std::size_t>(std::numeric_limits<Id>::max()) + 1) {
+        throw std::runtime_error("Too many sprite definitions!");
+    }
+    SDL_Texture* texture = graphics_.loadImage(file_name, true);
+    const auto first = static_cast<Id>(definitions_.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        definitions_.push_back(Definition{texture, SDL_Rect{
+                source_x + static_cast<units::Pixel>(i) * width, source_y,
+                width, height}});
+    }
+    return first;
+}
+
+void SpriteRegistry::draw(Id id, const Vector<units::Game>& pos) const
+{
+    const Definition& definition = definitions_[id];
+    graphics_.renderTexture(definition.texture,
+            units::gameToPixel(pos.x), units::gameToPixel(pos.y),
+            &definition.source_rect);
+}
+
+std::size_t SpriteRegistry::size() const
+{
+    return definitions_.size();
+}
@@ -0,0 +1,50 @@
+#ifndef SPRITE_REGISTRY_H_
+#define SPRITE_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "units.h"
+#include "vector.h"
+
+struct Graphics;
+
+// Immutable sprite definitions, a texture plus a source rectangle, shared
+// by everything that draws the same image. Definitions are added once at
+// load time and referred to by small ids afterwards, so drawing one is an
+// array index: no allocation and no texture cache lookup.
+//
+// Every Graphics owns one registry; ids are only meaningful to it.
+struct SpriteRegistry {
+    typedef uint16_t Id;
+
+    explicit SpriteRegistry(Graphics& graphics);
+
+    SpriteRegistry(const SpriteRegistry&)=delete;
+    SpriteRegistry& operator=(const SpriteRegistry&)=delete;
+
+    // Adds |count| definitions lying side by side to the right of
+    // (source_x, source_y) on the sheet and returns the id of the first;
+    // the others follow it in order.
+    Id add(const std::string& file_name,
+            units::Pixel source_x, units::Pixel source_y,
+            units::Pixel width, units::Pixel height,
+            std::size_t count=1);
+
+    void draw(Id id, const Vector<units::Game>& pos) const;
+
+    std::size_t size() const;
+
+private:
+    struct Definition {
+        SDL_Texture* texture;
+        SDL_Rect source_rect;
+    };
+
+    Graphics& graphics_;
+    std::vector<Definition> definitions_;
+};
+
+#endif /* SPRITE_REGISTRY_H_ */
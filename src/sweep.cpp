@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "map.h"
+#include "rectangle.h"
+#include "sweep.h"
+
+namespace {
+
+const TileHit kNoHit{false, 0, 0, 1.0, Vector<int>{0, 0}};
+
+// Span of motion time during which [low, high] moved by d * t touches the
+// tile span [start, end)
+struct Interval {
+    double enter;
+    double exit;
+};
+
+Interval overlapTimes(units::Game low, units::Game high, units::Game d,
+        units::Game start, units::Game end)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    if (d > 0.0) {
+        return Interval{(start - high) / d, (end - low) / d};
+    }
+    if (d < 0.0) {
+        return Interval{(end - low) / d, (start - high) / d};
+    }
+    if (high >= start && low < end) {
+        return Interval{-infinity, infinity};
+    }
+    return Interval{infinity, -infinity};
+}
+
+int gameToSignedTile(units::Game game)
+{
+    return static_cast<int>(std::floor(game / units::tileToGame(1)));
+}
+
+bool isWall(const Map& map, int row, int col)
+{
+    return row >= 0 && col >= 0 &&
+        map.getTileType(row, col) == Map::TileType::WALL;
+}
+
+} // anonymous namespace
+
+TileHit sweepRectangle(const Map& map, const Rectangle& rect,
+        Vector<units::Game> delta)
+{
+    // Every tile the rectangle can touch lies inside the swept bounds
+    const Rectangle swept(
+            std::min(rect.getLeft(), rect.getLeft() + delta.x),
+            std::min(rect.getTop(), rect.getTop() + delta.y),
+            rect.getWidth() + std::abs(delta.x),
+            rect.getHeight() + std::abs(delta.y));
+
+    TileHit first = kNoHit;
+    map.forEachWallTile(swept, [&](const Map::CollisionTile& tile) {
+        const units::Game tile_left = units::tileToGame(tile.col);
+        const units::Game tile_top = units::tileToGame(tile.row);
+        const Interval x = overlapTimes(rect.getLeft(), rect.getRight(),
+                delta.x, tile_left, tile_left + units::tileToGame(1));
+        const Interval y = overlapTimes(rect.getTop(), rect.getBottom(),
+                delta.y, tile_top, tile_top + units::tileToGame(1));
+
+        const double enter = std::max(x.enter, y.enter);
+        const double exit = std::min(x.exit, y.exit);
+        if (enter > exit || exit < 0.0 || enter > 1.0) {
+            return;
+        }
+        const double time = std::max(enter, 0.0);
+        // Ties keep the earlier tile in scan order, like getWallCollisionInfo
+        if (first.hit && time >= first.time) {
+            return;
+        }
+
+        Vector<int> normal{0, 0};
+        if (enter > 0.0) {
+            if (x.enter >= y.enter) {
+                normal.x = delta.x > 0.0 ? -1 : 1;
+            } else {
+                normal.y = delta.y > 0.0 ? -1 : 1;
+            }
+        }
+        first = TileHit{true, tile.row, tile.col, time, normal};
+    });
+    return first;
+}
+
+TileHit raycast(const Map& map, Vector<units::Game> origin,
+        Vector<units::Game> delta)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    const units::Game tile_size = units::tileToGame(1);
+
+    int col = gameToSignedTile(origin.x);
+    int row = gameToSignedTile(origin.y);
+    const int step_col = (delta.x > 0.0) - (delta.x < 0.0);
+    const int step_row = (delta.y > 0.0) - (delta.y < 0.0);
+
+    // Time to reach the next column/row boundary and time to cross one tile
+    double next_x = infinity;
+    double next_y = infinity;
+    double step_x = infinity;
+    double step_y = infinity;
+    if (step_col != 0) {
+        const units::Game boundary = (col + (step_col > 0)) * tile_size;
+        next_x = (boundary - origin.x) / delta.x;
+        step_x = tile_size / std::abs(delta.x);
+    }
+    if (step_row != 0) {
+        const units::Game boundary = (row + (step_row > 0)) * tile_size;
+        next_y = (boundary - origin.y) / delta.y;
+        step_y = tile_size / std::abs(delta.y);
+    }
+
+    double time = 0.0;
+    Vector<int> normal{0, 0};
+    while (time <= 1.0) {
+        if (isWall(map, row, col)) {
+            return TileHit{true, static_cast<units::Tile>(row),
+                static_cast<units::Tile>(col), time, normal};
+        }
+        if (next_x < next_y) {
+            col += step_col;
+            time = next_x;
+            next_x += step_x;
+            normal = Vector<int>{-step_col, 0};
+        } else {
+            row += step_row;
+            time = next_y;
+            next_y += step_y;
+            normal = Vector<int>{0, -step_row};
+        }
+    }
+    return kNoHit;
+}
@@ -0,0 +1,33 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include "units.h"
+#include "vector.h"
+
+struct Map;
+struct Rectangle;
+
+// Continuous collision against the WALL tiles of a Map. Motion is given as a
+// displacement |delta|; |time| is the fraction of it travelled before the
+// first contact, so 0 means the shape already touches the wall.
+struct TileHit {
+    bool hit;
+    units::Tile row;
+    units::Tile col;
+    double time;
+    // Outward normal of the face that was hit, {0, 0} if we started inside
+    Vector<int> normal;
+};
+
+// Moves |rect| by |delta| and returns the first wall tile it runs into.
+// Overlap follows Map::getWallCollisionInfo(): a tile [x, x + tile) is
+// touched by a rectangle [left, right] when left < x + tile and right >= x.
+TileHit sweepRectangle(const Map& map, const Rectangle& rect,
+        Vector<units::Game> delta);
+
+// Walks the grid cell by cell (DDA) from |origin| to |origin + delta| and
+// returns the first wall tile the segment enters.
+TileHit raycast(const Map& map, Vector<units::Game> origin,
+        Vector<units::Game> delta);
+
+#endif /* SWEEP_H_ */
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cassert>
+#include "text_renderer.h"
+#include "graphics.h"
+
+const std::string kTextBoxPath{"TextBox"};
+const units::Game kDigitsWhiteY{7 * units::kHalfTile};
+const units::Game kDigitsRedY{8 * units::kHalfTile};
+const units::Game kSignsY{6 * units::kHalfTile};
+const units::Game kPlusX{4 * units::kHalfTile};
+const units::Game kMinusX{5 * units::kHalfTile};
+
+const int kRadix{10};
+
+const units::Game TextRenderer::kGlyphWidth{units::kHalfTile};
+const units::Game TextRenderer::kGlyphHeight{units::kHalfTile};
+const std::size_t TextRenderer::kNumCharacters;
+const SpriteRegistry::Id TextRenderer::kNoGlyph;
+
+const std::size_t TextLabel::kMaxLength;
+
+TextRenderer::TextRenderer(Graphics& graphics) :
+    sprites_(graphics.getSpriteRegistry()),
+    glyphs_()
+{
+    std::fill_n(&glyphs_[0][0],
+            static_cast<int>(Font::LAST) * kNumCharacters, kNoGlyph);
+
+    addGlyphs(Font::WHITE, '0', kRadix, kTextBoxPath,
+            0, units::gameToPixel(kDigitsWhiteY));
+    addGlyphs(Font::RED, '0', kRadix, kTextBoxPath,
+            0, units::gameToPixel(kDigitsRedY));
+    // Both colors share the signs
+    for (auto font : {Font::WHITE, Font::RED}) {
+        addGlyphs(font, '+', 1, kTextBoxPath,
+                units::gameToPixel(kPlusX), units::gameToPixel(kSignsY));
+        addGlyphs(font, '-', 1, kTextBoxPath,
+                units::gameToPixel(kMinusX), units::gameToPixel(kSignsY));
+    }
+}
+
+void TextRenderer::addGlyphs(Font font, char first, std::size_t count,
+        const std::string& file_name,
+        units::Pixel source_x, units::Pixel source_y)
+{
+    const auto code = static_cast<std::size_t>(first);
+    assert(code + count <= kNumCharacters && "Glyphs must be ASCII!");
+    const SpriteRegistry::Id id = sprites_.add(file_name, source_x, source_y,
+            units::gameToPixel(kGlyphWidth), units::gameToPixel(kGlyphHeight),
+            count);
+    for (std::size_t i = 0; i < count; ++i) {
+        glyphs_[static_cast<int>(font)][code + i] =
+            static_cast<SpriteRegistry::Id>(id + i);
+    }
+}
+
+void TextRenderer::drawText(Font font, const char* text, std::size_t length,
+        Vector<units::Game> pos) const
+{
+    const SpriteRegistry::Id* glyphs = glyphs_[static_cast<int>(font)];
+    for (std::size_t i = 0; i < length; ++i, pos.x += kGlyphWidth) {
+        const auto code = static_cast<unsigned char>(text[i]);
+        if (code < kNumCharacters && glyphs[code] != kNoGlyph) {
+            sprites_.draw(glyphs[code], pos);
+        }
+    }
+}
+
+TextLabel::TextLabel(TextRenderer::Font font) :
+    font_(font),
+    has_number_{false},
+    number_{0},
+    sign_(Sign::NONE),
+    width_{0},
+    text_(),
+    length_{0}
+{}
+
+void TextLabel::setNumber(int number, Sign sign, std::size_t width)
+{
+    if (has_number_ && number == number_ && sign == sign_ && width == width_) {
+        return;
+    }
+    has_number_ = true;
+    number_ = number;
+    sign_ = sign;
+    width_ = width;
+
+    // Digits are produced backwards from the end of the buffer; unsigned so
+    // that the most negative int has a magnitude
+    char digits[kMaxLength];
+    std::size_t first = kMaxLength;
+    unsigned magnitude = (number < 0)
+        ? 0u - static_cast<unsigned>(number)
+        : static_cast<unsigned>(number);
+    do {
+        digits[--first] = static_cast<char>('0' + magnitude % kRadix);
+        magnitude /= kRadix;
+    } while (magnitude != 0);
+    if (number < 0) {
+        digits[--first] = '-';
+    }
+    switch (sign) {
+    case Sign::PLUS:
+        digits[--first] = '+';
+        break;
+    case Sign::MINUS:
+        digits[--first] = '-';
+        break;
+    case Sign::NONE:
+        break;
+    }
+
+    const std::size_t used = kMaxLength - first;
+    const std::size_t padding =
+        std::min(kMaxLength, std::max(width, used)) - used;
+    std::fill_n(text_, padding, ' ');
+    std::copy(digits + first, digits + kMaxLength, text_ + padding);
+    length_ = padding + used;
+}
+
+void TextLabel::draw(Graphics& graphics, Vector<units::Game> pos) const
+{
+    graphics.getTextRenderer().drawText(font_, text_, length_, pos);
+}
+
+void TextLabel::drawCentered(Graphics& graphics, Vector<units::Game> pos) const
+{
+    pos.x -= getWidth() / 2;
+    pos.y -= TextRenderer::kGlyphHeight / 2;
+    draw(graphics, pos);
+}
+
+units::Game TextLabel::getWidth() const
+{
+    return TextRenderer::kGlyphWidth * length_;
+}
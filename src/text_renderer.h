@@ -0,0 +1,85 @@
+#ifndef TEXT_RENDERER_H_
+#define TEXT_RENDERER_H_
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include "sprite_registry.h"
+#include "units.h"
+#include "vector.h"
+
+struct Graphics;
+
+// Draws text in fixed-width bitmap fonts. Each font is a table from
+// character to sprite id, filled once from the sheets, so drawing a string
+// is a lookup and a draw call per character with no allocation. Characters
+// without a glyph, such as the space, leave a blank cell.
+struct TextRenderer {
+    enum class Font {
+        WHITE,
+        RED,
+        LAST
+    };
+
+    static const units::Game kGlyphWidth;
+    static const units::Game kGlyphHeight;
+
+    explicit TextRenderer(Graphics& graphics);
+
+    TextRenderer(const TextRenderer&)=delete;
+    TextRenderer& operator=(const TextRenderer&)=delete;
+
+    // Gives |count| consecutive characters starting at |first| the glyphs
+    // lying side by side to the right of (source_x, source_y) on the sheet.
+    void addGlyphs(Font font, char first, std::size_t count,
+            const std::string& file_name,
+            units::Pixel source_x, units::Pixel source_y);
+
+    void drawText(Font font, const char* text, std::size_t length,
+            Vector<units::Game> pos) const;
+
+private:
+    static const std::size_t kNumCharacters{128};
+    static const SpriteRegistry::Id kNoGlyph{
+        std::numeric_limits<SpriteRegistry::Id>::max()};
+
+    SpriteRegistry& sprites_;
+    SpriteRegistry::Id glyphs_[static_cast<int>(Font::LAST)][kNumCharacters];
+};
+
+// A line of text kept between frames. Setting the same content again is a
+// comparison, so callers can refresh it every frame and only pay for
+// formatting when it changes.
+struct TextLabel {
+    enum class Sign {
+        NONE,
+        PLUS,
+        MINUS
+    };
+
+    // Every digit of an int plus two signs
+    static const std::size_t kMaxLength{std::numeric_limits<int>::digits10 + 3};
+
+    explicit TextLabel(TextRenderer::Font font);
+
+    // Writes |number| after |sign|, right aligned in |width| characters if
+    // it is shorter. Negative numbers always get a minus.
+    void setNumber(int number, Sign sign=Sign::NONE, std::size_t width=0);
+
+    void draw(Graphics& graphics, Vector<units::Game> pos) const;
+    void drawCentered(Graphics& graphics, Vector<units::Game> pos) const;
+
+    units::Game getWidth() const;
+
+private:
+    TextRenderer::Font font_;
+    bool has_number_;
+    int number_;
+    Sign sign_;
+    std::size_t width_;
+
+    char text_[kMaxLength];
+    std::size_t length_;
+};
+
+#endif /* TEXT_RENDERER_H_ */
@@ -1,6 +1,8 @@
 #include "timer.h"
+#include "savestate.h"
 
 std::set<Timer*> Timer::timers_;
+milliseconds Timer::now_{0};
 
 Timer::Timer(milliseconds expiration_time, bool start_active) :
     current_time_{ start_active ? 0 :  expiration_time.count() + 1},
@@ -34,13 +36,39 @@ milliseconds Timer::current_time() const
     return current_time_;
 }
 
+void Timer::save(StateWriter& writer) const
+{
+    writer.write(current_time_);
+}
+
+void Timer::restore(StateReader& reader)
+{
+    reader.read(current_time_);
+}
+
 void Timer::updateAll(milliseconds elapsed_time)
 {
+    now_ += elapsed_time;
     for (auto timer: timers_) {
         timer->update(elapsed_time);
     }
 }
 
+milliseconds Timer::now()
+{
+    return now_;
+}
+
+void Timer::saveClock(StateWriter& writer)
+{
+    writer.write(now_);
+}
+
+void Timer::restoreClock(StateReader& reader)
+{
+    reader.read(now_);
+}
+
 void Timer::update(milliseconds elapsed_time)
 {
     if (is_active()) {
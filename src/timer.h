@@ -6,6 +6,9 @@
 
 using std::chrono::milliseconds;
 
+struct StateReader;
+struct StateWriter;
+
 struct Timer {
    Timer(milliseconds expiration_time, bool start_active=false);
    Timer(const Timer&)=delete;
@@ -19,13 +22,23 @@ struct Timer {
 
    milliseconds current_time() const;
 
+   // Savestate of the time on this timer
+   void save(StateWriter& writer) const;
+   void restore(StateReader& reader);
+
    static void updateAll(milliseconds elapsed_time);
+   // World clock: the total time passed to updateAll
+   static milliseconds now();
+   // Savestate of the world clock
+   static void saveClock(StateWriter& writer);
+   static void restoreClock(StateReader& reader);
 private:
    void update(milliseconds elapsed_time);
    milliseconds current_time_;
    const milliseconds expiration_time_;
 
    static std::set<Timer*> timers_;
+   static milliseconds now_;
 };
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,182 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "trace.h"
+
+namespace {
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Event {
+    const char* name;
+    // Nanoseconds since start()
+    uint64_t start_time;
+    uint64_t duration;
+};
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(std::size_t id) :
+        id{id},
+        name(),
+        events(),
+        size{0}
+    {}
+
+    const std::size_t id;
+    std::string name;
+    // Allocated by the first zone, so naming a thread costs no memory
+    std::vector<Event> events;
+    // Events ever recorded; the latest kEventsPerThread are kept
+    std::atomic<uint64_t> size;
+};
+
+// Buffers outlive their threads, so zones of finished threads still show
+struct Registry {
+    Registry() :
+        mutex(),
+        buffers(),
+        start_time{0}
+    {}
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer> > buffers;
+    // Clock time of start(), read by every zone without the lock
+    std::atomic<Clock::rep> start_time;
+};
+
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& getThreadBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(
+                std::make_unique<ThreadBuffer>(registry.buffers.size() + 1));
+        buffer = registry.buffers.back().get();
+    }
+    return *buffer;
+}
+
+// Names are literals from the source, but keep the JSON valid regardless
+void writeString(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            out << '\\';
+        }
+        out << *text;
+    }
+    out << '"';
+}
+
+} // anonymous namespace
+
+namespace trace {
+
+namespace detail {
+
+std::atomic<bool> enabled{false};
+
+uint64_t now()
+{
+    const Clock::duration elapsed = Clock::now().time_since_epoch() -
+        Clock::duration(getRegistry().start_time.load(
+                    std::memory_order_relaxed));
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            elapsed).count();
+}
+
+void record(const char* name, uint64_t start_time)
+{
+    const uint64_t end_time = now();
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ThreadBuffer& buffer = getThreadBuffer();
+    // Only this thread writes its buffer
+    if (buffer.events.empty()) {
+        buffer.events.resize(kEventsPerThread);
+    }
+    const uint64_t size = buffer.size.load(std::memory_order_relaxed);
+    buffer.events[size % kEventsPerThread] =
+        Event{name, start_time, end_time - start_time};
+    buffer.size.store(size + 1, std::memory_order_release);
+}
+
+} // detail
+
+void start()
+{
+    Registry& registry = getRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto& buffer : registry.buffers) {
+            buffer->size.store(0, std::memory_order_relaxed);
+        }
+        registry.start_time.store(Clock::now().time_since_epoch().count(),
+                std::memory_order_relaxed);
+    }
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+void stop()
+{
+    detail::enabled.store(false, std::memory_order_release);
+}
+
+void setThreadName(const char* name)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(getRegistry().mutex);
+    buffer.name = name;
+}
+
+void write(const std::string& file_path)
+{
+    std::ofstream file(file_path);
+    file << std::fixed << std::setprecision(3)
+        << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    bool first{true};
+    for (const auto& buffer : registry.buffers) {
+        if (!buffer->name.empty()) {
+            file << (first ? "" : ",\n")
+                << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                << buffer->id << ",\"args\":{\"name\":";
+            writeString(file, buffer->name.c_str());
+            file << "}}";
+            first = false;
+        }
+        const uint64_t size = buffer->size.load(std::memory_order_acquire);
+        const uint64_t oldest =
+            (size > kEventsPerThread) ? size - kEventsPerThread : 0;
+        for (uint64_t i = oldest; i < size; ++i) {
+            const Event& event = buffer->events[i % kEventsPerThread];
+            file << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+            writeString(file, event.name);
+            file << ",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << event.start_time / 1000.0
+                << ",\"dur\":" << event.duration / 1000.0 << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("Cannot write trace '" + file_path + "'");
+    }
+}
+
+} // trace
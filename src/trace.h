@@ -0,0 +1,72 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Timeline of scoped zones, written as Chrome trace-event JSON for
+// chrome://tracing and ui.perfetto.dev. Mark a zone by naming a scope:
+//
+//   void Map::update(const Rectangle& view)
+//   {
+//       TRACE_ZONE("Map::update");
+//       ...
+//
+// Names must be string literals; only the pointer is kept. Every thread
+// records into its own ring buffer, so zones never contend, and a long
+// session keeps its latest kEventsPerThread zones per thread. Until
+// start(), a zone costs one relaxed atomic load and a branch.
+namespace trace {
+
+const std::size_t kEventsPerThread{1 << 16};
+
+// Clears what was recorded and starts recording
+void start();
+void stop();
+// Names the calling thread in the timeline
+void setThreadName(const char* name);
+// Writes the recorded zones of every thread. Call it after stop(); zones
+// still being recorded would race with it. Throws std::runtime_error if
+// the file cannot be written.
+void write(const std::string& file_path);
+
+namespace detail {
+
+extern std::atomic<bool> enabled;
+
+uint64_t now();
+void record(const char* name, uint64_t start_time);
+
+} // detail
+
+struct Zone {
+    explicit Zone(const char* name) :
+        name_{detail::enabled.load(std::memory_order_relaxed)
+            ? name : nullptr},
+        start_time_{name_ ? detail::now() : 0}
+    {}
+    Zone(const Zone&)=delete;
+    Zone& operator=(const Zone&)=delete;
+
+    ~Zone()
+    {
+        if (name_) {
+            detail::record(name_, start_time_);
+        }
+    }
+
+private:
+    const char* const name_;
+    const uint64_t start_time_;
+};
+
+} // trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) \
+    trace::Zone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,108 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "udp_link.h"
+
+#if defined(__SWITCH__)
+#include <switch.h>
+#endif
+
+const std::size_t UdpLink::kMaxDatagramSize;
+
+namespace {
+
+std::runtime_error socketError(const std::string& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// The Switch needs its socket service started before the first socket
+void initializeSockets()
+{
+#if defined(__SWITCH__)
+    static const bool initialized = R_SUCCEEDED(socketInitializeDefault());
+    if (!initialized) {
+        throw std::runtime_error("Cannot start the socket service");
+    }
+#endif
+}
+
+} // anonymous namespace
+
+UdpLink::UdpLink(uint16_t local_port, const std::string& remote_host,
+        uint16_t remote_port) :
+    socket_{-1},
+    remote_()
+{
+    initializeSockets();
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(remote_host.c_str(), nullptr, &hints, &addresses) != 0 ||
+            addresses == nullptr) {
+        throw std::runtime_error("Cannot resolve '" + remote_host + "'");
+    }
+    std::memcpy(&remote_, addresses->ai_addr, sizeof(remote_));
+    freeaddrinfo(addresses);
+    remote_.sin_port = htons(remote_port);
+
+    socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ < 0) {
+        throw socketError("socket");
+    }
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(local_port);
+    if (bind(socket_, reinterpret_cast<const sockaddr*>(&local),
+                sizeof(local)) < 0 ||
+            fcntl(socket_, F_SETFL, fcntl(socket_, F_GETFL) | O_NONBLOCK) < 0) {
+        const auto error = socketError("Cannot open UDP port " +
+                std::to_string(local_port));
+        close(socket_);
+        throw error;
+    }
+}
+
+UdpLink::~UdpLink()
+{
+    close(socket_);
+}
+
+void UdpLink::send(const unsigned char* data, std::size_t size)
+{
+    // A full send buffer is just one more lost datagram
+    sendto(socket_, data, size, 0,
+            reinterpret_cast<const sockaddr*>(&remote_), sizeof(remote_));
+}
+
+bool UdpLink::receive(std::vector<unsigned char>& datagram)
+{
+    datagram.resize(kMaxDatagramSize);
+    for (;;) {
+        sockaddr_in sender;
+        socklen_t sender_size = sizeof(sender);
+        const ssize_t size = recvfrom(socket_, datagram.data(),
+                datagram.size(), 0,
+                reinterpret_cast<sockaddr*>(&sender), &sender_size);
+        if (size < 0) {
+            datagram.clear();
+            return false;
+        }
+        // Drop strays from anyone but the peer
+        if (sender.sin_addr.s_addr == remote_.sin_addr.s_addr &&
+                sender.sin_port == remote_.sin_port) {
+            datagram.resize(size);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef UDP_LINK_H_
+#define UDP_LINK_H_
+
+#include <netinet/in.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Unreliable transport of small packets to one peer: datagrams may be
+// lost, duplicated or arrive out of order.
+struct DatagramLink {
+    virtual ~DatagramLink() = default;
+    virtual void send(const unsigned char* data, std::size_t size) = 0;
+    // Moves the next waiting datagram into |datagram|; false if none
+    virtual bool receive(std::vector<unsigned char>& datagram) = 0;
+};
+
+// DatagramLink over a nonblocking UDP socket bound to |local_port|, which
+// only talks to |remote_host|:|remote_port|. Throws std::runtime_error when
+// the socket cannot be set up.
+struct UdpLink final : public DatagramLink {
+    static const std::size_t kMaxDatagramSize{1024};
+
+    UdpLink(uint16_t local_port, const std::string& remote_host,
+            uint16_t remote_port);
+    UdpLink(const UdpLink&)=delete;
+    UdpLink& operator=(const UdpLink&)=delete;
+    ~UdpLink();
+
+    void send(const unsigned char* data, std::size_t size) override;
+    bool receive(std::vector<unsigned char>& datagram) override;
+
+private:
+    int socket_;
+    sockaddr_in remote_;
+};
+
+#endif /* UDP_LINK_H_ */
@@ -0,0 +1,17 @@
+#include "units.h"
+
+#if UNITS_TRIG == UNITS_TRIG_TABLE
+namespace units {
+    namespace detail {
+        SineTable::SineTable()
+        {
+            for (std::size_t i = 0; i <= kSineTableSize; ++i) {
+                samples[i] = sinPolynomial(
+                        static_cast<double>(i) / kSineTableSize);
+            }
+        }
+
+        const SineTable kSineTable;
+    }
+} // units
+#endif
@@ -2,8 +2,20 @@
 #define UNITS_H_
 
 #include <cmath>
+#include <cstddef>
 #include "config.h"
 
+// Implementation of units::sin() and units::cos(), picked at build time with
+// e.g. DEFINES=-DUNITS_TRIG=0. The table and the polynomial only use basic
+// arithmetic, so they give the same bits on every platform as long as the
+// compiler does not contract it into FMA; the builds pass -ffp-contract=off.
+#define UNITS_TRIG_LIBM 0
+#define UNITS_TRIG_TABLE 1
+#define UNITS_TRIG_POLYNOMIAL 2
+#ifndef UNITS_TRIG
+#define UNITS_TRIG UNITS_TRIG_POLYNOMIAL
+#endif
+
 namespace units {
     typedef int HP;
 
@@ -20,14 +32,75 @@ namespace units {
     typedef double AngularVelocity; // Degrees / milliseconds
 
     namespace {
-        const Game kTileSize{32.0};
+        constexpr Game kTileSize{32.0};
         const double kPi{atan(1) * 4};
     }
 
+    // Doubles filling one 128-bit SIMD register (SSE2, NEON)
+    const std::size_t kNumLanes{2};
+    typedef double Lanes
+        __attribute__((vector_size(kNumLanes * sizeof(double))));
+
+    namespace detail {
+        // Nearest integer, for |x| < 2^51
+        template <typename T>
+        inline T roundToInteger(T x) {
+            const double kShift{6755399441055744.0}; // 1.5 * 2^52
+            return (x + kShift) - kShift;
+        }
+
+        // sin(2 pi turns) from an odd Taylor polynomial over a quarter
+        // turn, accurate to 1e-9. Branch free, so T may be Lanes.
+        template <typename T>
+        inline T sinPolynomial(T turns) {
+            const T x = turns - roundToInteger(turns);
+            const T magnitude = x < 0.0 ? -x : x;
+            const T folded = 0.5 - magnitude < magnitude
+                ? 0.5 - magnitude
+                : magnitude;
+            const T r = folded * (2.0 * kPi);
+            const T r2 = r * r;
+            T p = T() - 1.0 / 6227020800.0;
+            p = p * r2 + 1.0 / 39916800.0;
+            p = p * r2 - 1.0 / 362880.0;
+            p = p * r2 + 1.0 / 5040.0;
+            p = p * r2 - 1.0 / 120.0;
+            p = p * r2 + 1.0 / 6.0;
+            const T sine = r - r * r2 * p;
+            return x < 0.0 ? -sine : sine;
+        }
+
+#if UNITS_TRIG == UNITS_TRIG_TABLE
+        // Samples of sinPolynomial() over one turn, the first repeated at
+        // the end; defined in units.cpp
+        const std::size_t kSineTableSize{4096};
+        struct SineTable {
+            SineTable();
+            double samples[kSineTableSize + 1];
+        };
+        extern const SineTable kSineTable;
+
+        inline double sinTurns(double turns) {
+            const double position = turns * kSineTableSize;
+            const double base = std::floor(position);
+            const auto i = static_cast<std::size_t>(
+                    static_cast<long long>(base)) & (kSineTableSize - 1);
+            const double* samples = kSineTable.samples;
+            return samples[i] +
+                (samples[i + 1] - samples[i]) * (position - base);
+        }
+#elif UNITS_TRIG == UNITS_TRIG_POLYNOMIAL
+        inline double sinTurns(double turns) {
+            return sinPolynomial(turns);
+        }
+#endif
+    }
+
     inline double degreesToRadians(Degrees degrees) {
         return degrees * kPi / 180.0;
     }
 
+#if UNITS_TRIG == UNITS_TRIG_LIBM
     inline Game sin(Degrees degrees) {
         return static_cast<Game>(std::sin(degreesToRadians(degrees)));
     }
@@ -35,6 +108,28 @@ namespace units {
     inline Game cos(Degrees degrees) {
         return static_cast<Game>(std::cos(degreesToRadians(degrees)));
     }
+#else
+    inline Game sin(Degrees degrees) {
+        return detail::sinTurns(degrees / 360.0);
+    }
+
+    inline Game cos(Degrees degrees) {
+        return detail::sinTurns(degrees / 360.0 + 0.25);
+    }
+#endif
+
+    // sin() of every lane; the same bits as calling sin() on each
+    inline Lanes sin(Lanes degrees) {
+#if UNITS_TRIG == UNITS_TRIG_POLYNOMIAL
+        return detail::sinPolynomial(degrees / 360.0);
+#else
+        Lanes sines;
+        for (std::size_t i = 0; i < kNumLanes; ++i) {
+            sines[i] = sin(degrees[i]);
+        }
+        return sines;
+#endif
+    }
 
     inline Pixel gameToPixel(Game game) {
         if (config::getGraphicsQuality() == config::GraphicsQuality::HIGH) {
@@ -46,14 +141,14 @@ namespace units {
     inline Tile gameToTile(Game game) {
         return Tile(game / kTileSize);
     }
-    inline Game tileToGame(Tile tile) {
+    constexpr Game tileToGame(Tile tile) {
         return tile * kTileSize;
     }
     inline Pixel tileToPixel(Tile tile) {
         return gameToPixel(tileToGame(tile));
     }
 
-    const Game kHalfTile{tileToGame(1) / 2.0};
+    constexpr Game kHalfTile{tileToGame(1) / 2.0};
 } // units
 
 #endif /* UNITS_H_ */